@@ -2,5 +2,16 @@
 
 const uint32_t _THERMO8_I2C_CFG[ 1 ] = 
 { 
-	_I2C_100KHZ 
+	_I2C_400KHZ             // Fast mode, _I2C_100KHZ for Standard mode
+};
+
+const T_thermo8_profile _THERMO8_PROFILE =
+{
+	0x01,                   // THERMO8_R025C_65MS
+	28 * 16,                // TUPPER 28.0 C
+	27 * 16,                // TLOWER 27.0 C
+	0,                      // TCRIT
+	0x00,                   // THERMO8_THYS_0C
+	0,                      // THERMO8_ALERT_ON_ALL
+	0                       // no locks
 };
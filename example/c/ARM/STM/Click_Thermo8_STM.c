@@ -18,7 +18,9 @@ The application is composed of three sections :
 
 - System Initialization - Initialize the GPIO, I2C and LOG structures.
 - Application Initialization - Initialize the communication interface and
-                               configure the click board.
+                               configure the click board. After a warm reset
+                               the configuration is kept when it already
+                               matches.
 - Application Task - Wait for the interrupt pin to be triggered. When the
                    measured temperature breaches the upper or lower limit the
                    temperature value as well as the status of the breach is
@@ -39,13 +41,17 @@ void systemInit()
 void applicationInit()
 {
      thermo8_i2cDriverInit( (T_THERMO8_P)&_MIKROBUS1_GPIO, (T_THERMO8_P)&_MIKROBUS1_I2C, THERMO8_ADDR0 );
+     thermo8_busHzSet( 400000 );                // Fast mode, as in _THERMO8_I2C_CFG
      mikrobus_logWrite("System initialized",_LOG_LINE);
+
+     if( thermo8_warmBootCheck( &_THERMO8_PROFILE ) )
+     {
+         mikrobus_logWrite("Warm boot - configuration kept",_LOG_LINE);
+         return;
+     }
      Delay_ms(100);
-     
-     thermo8_setResolution( THERMO8_R025C_65MS );
-     thermo8_limitSet(THERMO8_TLOWER, 27.0);
-     thermo8_limitSet(THERMO8_TUPPER, 28.0);
-     thermo8_alertEnable(THERMO8_THYS_0C,THERMO8_ALERT_ON_ALL);
+
+     thermo8_profileApply( &_THERMO8_PROFILE );
 }
 
 void applicationTask()
@@ -18,7 +18,7 @@ const uint32_t _THERMO8_SPI_CFG[ 2 ] =
 #ifdef  ENABLE_I2C
 const uint32_t _THERMO8_I2C_CFG[ 1 ] = 
 {
-	100000
+	400000                  // Fast mode, 100000 for Standard mode
 };
 #endif
 
@@ -31,3 +31,14 @@ const uint32_t _THERMO8_UART_CFG [ 4 ] =
     _UART_ONE_STOPBIT
 };
 #endif
+
+const T_thermo8_profile _THERMO8_PROFILE =
+{
+	0x01,                   // THERMO8_R025C_65MS
+	28 * 16,                // TUPPER 28.0 C
+	27 * 16,                // TLOWER 27.0 C
+	0,                      // TCRIT
+	0x00,                   // THERMO8_THYS_0C
+	0,                      // THERMO8_ALERT_ON_ALL
+	0                       // no locks
+};
@@ -2,6 +2,17 @@
 
 const uint32_t _THERMO8_I2C_CFG[ 2 ] =  
 {
-	_I2CM_SPEED_MODE_STANDARD, 
+	_I2CM_SPEED_MODE_FAST,  // _I2CM_SPEED_MODE_STANDARD for 100 kHz
 	_I2CM_SWAP_DISABLE
 };
+
+const T_thermo8_profile _THERMO8_PROFILE =
+{
+	0x01,                   // THERMO8_R025C_65MS
+	28 * 16,                // TUPPER 28.0 C
+	27 * 16,                // TLOWER 27.0 C
+	0,                      // TCRIT
+	0x00,                   // THERMO8_THYS_0C
+	0,                      // THERMO8_ALERT_ON_ALL
+	0                       // no locks
+};
@@ -15,21 +15,54 @@
 #include "__thermo8_hal.c"
 
 /* ------------------------------------------------------------------- MACROS */
+// Bus binding, see __THERMO8_BUS_STATIC__ and __THERMO8_BUS_SOFT__
+#ifdef __THERMO8_BUS_SOFT__
+#define THERMO8_BUS_START()                     _swStart()
+#define THERMO8_BUS_WRITE(addr, buf, n, mode)   _swWrite(addr, buf, n, mode)
+#define THERMO8_BUS_READ(addr, buf, n, mode)    _swRead(addr, buf, n, mode)
+#define THERMO8_INT_GET()                       hal_gpio_intGet()
+#else
+#ifndef __THERMO8_BUS_STATIC__
+#define THERMO8_BUS_START()                     hal_i2cStart()
+#define THERMO8_BUS_WRITE(addr, buf, n, mode)   hal_i2cWrite(addr, buf, n, mode)
+#define THERMO8_BUS_READ(addr, buf, n, mode)    hal_i2cRead(addr, buf, n, mode)
+#define THERMO8_INT_GET()                       hal_gpio_intGet()
+#endif
+#endif
+
+#ifndef THERMO8_ASYNC_ENTER
+#define THERMO8_ASYNC_ENTER()
+#define THERMO8_ASYNC_EXIT()
+#endif
+
+// Pointer aliasing hint for the batch loops, compilers without it get none
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define _THERMO8_RESTRICT                       __restrict
+#else
+#define _THERMO8_RESTRICT
+#endif
+
+// Runs body for every word j < n, mostly in blocks of 16 words whose
+// constant trip count lets the compiler vectorize without a remainder loop
+#define _THERMO8_BATCH(body)                    for( i = 0; i + 16 <= n; i += 16 ) \
+                                                { for( k = 0; k < 16; k++ ) { j = i + k; body; } } \
+                                                for( j = i; j < n; j++ ) { body; }
+
 // Temperature range -20 - +100
-const uint8_t THERMO8_ADDR0                           = 0x18; //def addr
-const uint8_t THERMO8_ADDR1                           = 0x18 | 0x01;
-const uint8_t THERMO8_ADDR2                           = 0x18 | 0x02;
-const uint8_t THERMO8_ADDR3                           = 0x18 | 0x03;
-const uint8_t THERMO8_ADDR4                           = 0x18 | 0x04;
-const uint8_t THERMO8_ADDR5                           = 0x18 | 0x05;
-const uint8_t THERMO8_ADDR6                           = 0x18 | 0x06;
-const uint8_t THERMO8_ADDR7                           = 0x18 | 0x07;
-
-const uint8_t THERMO8_CONFIG                          = 0x01;
-
-const uint8_t THERMO8_TUPPER                          = 0x02;
-const uint8_t THERMO8_TLOWER                          = 0x03;
-const uint8_t THERMO8_TCRIT                           = 0x04;
+const uint8_t THERMO8_ADDR0                           = THERMO8_ADDR_BASE; //def addr
+const uint8_t THERMO8_ADDR1                           = THERMO8_ADDR_BASE | 0x01;
+const uint8_t THERMO8_ADDR2                           = THERMO8_ADDR_BASE | 0x02;
+const uint8_t THERMO8_ADDR3                           = THERMO8_ADDR_BASE | 0x03;
+const uint8_t THERMO8_ADDR4                           = THERMO8_ADDR_BASE | 0x04;
+const uint8_t THERMO8_ADDR5                           = THERMO8_ADDR_BASE | 0x05;
+const uint8_t THERMO8_ADDR6                           = THERMO8_ADDR_BASE | 0x06;
+const uint8_t THERMO8_ADDR7                           = THERMO8_ADDR_BASE | 0x07;
+
+const uint8_t THERMO8_CONFIG                          = THERMO8_REG_CONFIG;
+
+const uint8_t THERMO8_TUPPER                          = THERMO8_REG_TUPPER;
+const uint8_t THERMO8_TLOWER                          = THERMO8_REG_TLOWER;
+const uint8_t THERMO8_TCRIT                           = THERMO8_REG_TCRIT;
 const uint8_t THERMO8_TUPPER_REACHED                  = 0x03;
 const uint8_t THERMO8_TLOWER_REACHED                  = 0x0C;
 const uint8_t THERMO8_TCRIT_REACHED                   = 0x30;
@@ -40,241 +73,3388 @@ const uint8_t THERMO8_THYS_1C5                        = 0x01;
 const uint8_t THERMO8_THYS_3C                         = 0x02;
 const uint8_t THERMO8_THYS_6C                         = 0x03;
 
-const uint8_t THERMO8_TA                              = 0x05;
-const uint8_t THERMO8_MANID                           = 0x06;
-const uint8_t THERMO8_DEVID                           = 0x07;
+const uint8_t THERMO8_TA                              = THERMO8_REG_TA;
+const uint8_t THERMO8_MANID                           = THERMO8_REG_MANID;
+const uint8_t THERMO8_DEVID                           = THERMO8_REG_DEVID;
 
-const uint8_t THERMO8_RESOLUTION_REG                  = 0x08;
+const uint8_t THERMO8_RESOLUTION_REG                  = THERMO8_REG_RESOLUTION;
 const uint8_t THERMO8_R05C_30MS                       = 0x00;
 const uint8_t THERMO8_R025C_65MS                      = 0x01;
 const uint8_t THERMO8_R0125C_130MS                    = 0x02;
 const uint8_t THERMO8_R00625C_250MS                   = 0x03;
 
+const uint8_t THERMO8_LOCK_WIN                        = 0x01;
+const uint8_t THERMO8_LOCK_CRIT                       = 0x02;
+
+const int THERMO8_ERR_LOCKED                          = -1;
+
+const uint8_t THERMO8_WIN_UPPER                       = 0x01;
+const uint8_t THERMO8_WIN_LOWER                       = 0x02;
+const uint8_t THERMO8_WIN_CRIT                        = 0x04;
+
+const uint16_t THERMO8_PRED_NEVER                     = 0xFFFF;
+
+const uint8_t THERMO8_SER_LOWER                       = 0x01;
+const uint8_t THERMO8_SER_UPPER                       = 0x02;
+const uint8_t THERMO8_SER_VALID                       = 0x80;
+
 /* ---------------------------------------------------------------- VARIABLES */
 
-#ifdef   __THERMO8_DRV_I2C__
-static uint8_t _slaveAddress;
-#endif
+// device used by the functions without a device argument
+static T_thermo8_dev _dev;
+
+static T_thermo8_lockFp _lockFp;
+static T_thermo8_lockFp _unlockFp;
+
+static T_thermo8_xfer* volatile _asyncQueue[ THERMO8_ASYNC_DEPTH ];
+static volatile uint8_t         _asyncHead;
+static volatile uint8_t         _asyncCount;
+static T_thermo8_asyncStartFp   _asyncStartFp;
+
+static uint32_t _taskNow;
+
+static uint8_t             _retries = THERMO8_RETRY;
+static T_thermo8_recoverFp _recoverFp;
+static T_thermo8_busStats  _busStats;
+
+// per device calibration, gain 0 is the identity
+static T_thermo8_cal _cal[ 8 ];
+
+// TCA9548A control registers, valid when the bit in _muxKnown is set,
+// 0xFF - open channels in an unknown state after a failed write
+static uint8_t _muxChan[ 8 ];
+static uint8_t _muxKnown;
+// a channel is open, cached registers would mix up equal addresses
+static uint8_t _muxOpen;
+
+// conversion time of each resolution setting
+static const uint16_t _convMs[ 4 ] = { 30, 65, 130, 250 };
 
-static uint16_t thermo8Limitstatus;
+static T_thermo8_inventory _inventory;
+
+// bus clock of the acquisition schedule check
+static uint32_t _busHz = THERMO8_BUS_HZ;
+
+// CONFIG, TUPPER, TLOWER, TCRIT and RESOLUTION as last seen on the bus
+typedef struct
+{
+    uint16_t    reg[ 5 ];
+    uint8_t     valid;
+
+}T_thermo8_regCache;
+
+static T_thermo8_regCache _regCache[ 8 ];
+
+// alert status and interrupt clear do not read back as written
+#define _THERMO8_CFG_CMP_MASK   ( ~( THERMO8_CFG_ALERT_STAT | THERMO8_CFG_INT_CLEAR ) & 0xFFFF )
+
+// layout version of thermo8_archBlockWrite() images
+#define _ARCH_VERSION           1
 
 /* -------------------------------------------- PRIVATE FUNCTION DECLARATIONS */
 float _btoTconversion(uint16_t rData);
 
+static int16_t _rawToCode(uint16_t rData);
+static uint32_t _mulSat(uint32_t a, uint32_t b);
+static uint32_t _mulDiv(uint32_t a, uint32_t b, uint32_t c, uint32_t *rem);
+static uint16_t _isqrt(uint32_t x);
+static int32_t _statsMeanQ4(const T_thermo8_stats *stats);
+static uint16_t _predEval(T_thermo8_pred *pred, int16_t limit);
+static int _read16(uint8_t slave, uint8_t rAddr, uint16_t *rData);
+static int _write16(uint8_t slave, uint8_t rAddr, uint16_t rData);
+static uint8_t _probe(uint8_t slave, uint8_t verifyManid);
+static int _write8(uint8_t slave, uint8_t rAddr, uint8_t rData);
+static void _cacheStore(uint8_t slave, uint8_t rAddr, uint16_t rData);
+static uint16_t _codeToLimit(int16_t code);
+static void _busLock();
+static void _busUnlock();
+static uint8_t _alertFlags(uint16_t status);
+static uint8_t _alertFlagsBits(uint16_t status);
+static void _taskXferDone(T_thermo8_xfer *xfer);
+static void _taskSubmit(T_thermo8_task *task, uint8_t rAddr, uint8_t write, uint16_t rData);
+static uint8_t _taskFail(T_thermo8_task *task);
+static uint16_t _convTime(uint8_t slave);
+static int _read8(uint8_t slave, uint8_t rAddr, uint8_t *rData);
+static int _shdnSet(uint8_t slave, uint8_t shdn);
+static int _muxWrite(uint8_t m, uint8_t ctl);
+static int _muxSelect(uint8_t mux, uint8_t channel);
+static int _muxRelease();
+static int _muxXfer(T_thermo8_muxDev *dev, uint8_t rAddr, uint16_t *rData, uint8_t write, uint8_t retries);
+static uint8_t _busRetry(uint8_t *tries, uint8_t retries);
+static int _read16n(uint8_t slave, uint8_t rAddr, uint16_t *rData, uint8_t retries);
+static int _read8n(uint8_t slave, uint8_t rAddr, uint8_t *rData, uint8_t retries);
+static int _write16n(uint8_t slave, uint8_t rAddr, uint16_t rData, uint8_t retries);
+static int _write8n(uint8_t slave, uint8_t rAddr, uint8_t rData, uint8_t retries);
+static int _cfgUpdate(uint16_t clr, uint16_t set);
+static uint16_t _muxKey(const T_thermo8_muxDev *dev);
+static int16_t _calApply(const T_thermo8_cal *cal, int16_t code);
+static int16_t _calFwd(uint8_t slave, int16_t code);
+static int16_t _calRev(uint8_t slave, int16_t code);
+static int16_t _median(int16_t *v, uint8_t n);
+static void _profileImage(uint8_t slave, const T_thermo8_profile *profile, uint16_t *img);
+static int _profileApply(uint8_t slave, const T_thermo8_profile *profile);
+static uint8_t *_putLe16(uint8_t *p, uint16_t v);
+static uint8_t *_putLe32(uint8_t *p, uint32_t v);
+static uint16_t _getLe16(const uint8_t *p);
+static uint32_t _getLe32(const uint8_t *p);
+static uint8_t _limitProgram(uint8_t slave, uint8_t rAddr, uint16_t rData, uint8_t locked);
+#ifdef __THERMO8_BUS_SOFT__
+static uint16_t _swRecover();
+static int _swStart();
+static int _swWrite(uint8_t slave, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode);
+static int _swRead(uint8_t slave, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode);
+#endif
+
 
 /* --------------------------------------------- PRIVATE FUNCTION DEFINITIONS */
 float _btoTconversion(uint16_t rData)
 {
-    float T;
-    uint8_t regUpper = (uint8_t)( rData>>8 );
-    uint8_t regLower = (uint8_t)( rData );
-    
-    regUpper &= 0x1F;
-    if( regUpper & 0x10 )
+    return (float)_rawToCode( rData ) / 16.0;
+}
+
+// sign extends the 13 bit two's complement field without branching
+static int16_t _rawToCode(uint16_t rData)
+{
+    return (int16_t)( ( rData & ( THERMO8_TA_SIGN | THERMO8_TA_VALUE ) ) ^ THERMO8_TA_SIGN ) - 0x1000;
+}
+
+static uint32_t _mulSat(uint32_t a, uint32_t b)
+{
+    if( ( a | b ) < 0x10000 )
     {
-      regUpper &= 0x0F;
-      T = 256.0 - ( ( (float)(regUpper) * 16.0 ) + ( (float)(regLower)/16.0 ) );
+      return a * b;
     }
-    else
+    if( ( a != 0 ) && ( b > 0xFFFFFFFF / a ) )
     {
-      T = ( ( (float)(regUpper) * 16.0 ) + ( (float)(regLower)/16.0 ) );
+      return 0xFFFFFFFF;
     }
-    
-    return T;
+    return a * b;
 }
 
+// floor( a * b / c ) over a 64 bit intermediate, quotient must fit 32 bits
+static uint32_t _mulDiv(uint32_t a, uint32_t b, uint32_t c, uint32_t *rem)
+{
+    uint32_t ll, lh, hl, mid;
+    uint32_t hi, lo, q, carry;
+    uint8_t i;
 
-/* --------------------------------------------------------- PUBLIC FUNCTIONS */
-#ifdef   __THERMO8_DRV_I2C__
+    ll  = ( a & 0xFFFF ) * ( b & 0xFFFF );
+    lh  = ( a & 0xFFFF ) * ( b >> 16 );
+    hl  = ( a >> 16 ) * ( b & 0xFFFF );
+    mid = ( ll >> 16 ) + ( lh & 0xFFFF ) + ( hl & 0xFFFF );
+    lo  = ( ll & 0xFFFF ) | ( mid << 16 );
+    hi  = ( a >> 16 ) * ( b >> 16 ) + ( lh >> 16 ) + ( hl >> 16 ) + ( mid >> 16 );
 
-void thermo8_i2cDriverInit(T_THERMO8_P gpioObj, T_THERMO8_P i2cObj, uint8_t slave)
+    q = 0;
+    for( i = 0; i < 32; i++ )
+    {
+      carry = hi & 0x80000000;
+      hi = ( hi << 1 ) | ( lo >> 31 );
+      lo <<= 1;
+      q <<= 1;
+      if( carry || ( hi >= c ) )
+      {
+        hi -= c;
+        q |= 1;
+      }
+    }
+    *rem = hi;
+
+    return q;
+}
+
+static uint16_t _isqrt(uint32_t x)
 {
-    _slaveAddress = slave;
-    hal_i2cMap( (T_HAL_P)i2cObj );
-    hal_gpioMap( (T_HAL_P)gpioObj );
+    uint32_t res = 0;
+    uint32_t bit = 0x40000000;
+
+    while( bit > x )
+    {
+      bit >>= 2;
+    }
+    while( bit )
+    {
+      if( x >= res + bit )
+      {
+        x -= res + bit;
+        res = ( res >> 1 ) + bit;
+      }
+      else
+      {
+        res >>= 1;
+      }
+      bit >>= 2;
+    }
+
+    return (uint16_t)res;
 }
 
-#endif
-/* ----------------------------------------------------------- IMPLEMENTATION */
-uint8_t thermo8_aleGet()
+// mean in 1/256 C, rounded towards minus infinity
+static int32_t _statsMeanQ4(const T_thermo8_stats *stats)
+{
+    uint32_t rem;
+
+    if( stats->count == 0 )
+    {
+      return 0;
+    }
+    return (int32_t)stats->meanQ * 16 +
+           (int32_t)_mulDiv( stats->meanR, 16, stats->count, &rem );
+}
+
+
+static uint16_t _predEval(T_thermo8_pred *pred, int16_t limit)
 {
-    return hal_gpio_intGet();
+    int32_t  n;
+    int32_t  sx;
+    int32_t  denom;
+    int32_t  num;
+    int32_t  diff;
+    uint32_t c;
+    uint32_t samples;
+    uint32_t ms;
+    uint32_t rem;
+
+    n = pred->n;
+    if( n < 2 )
+    {
+        return THERMO8_PRED_NEVER;
+    }
+    sx    = n * ( n - 1 ) / 2;
+    denom = n * ( ( n - 1 ) * n * ( 2 * n - 1 ) / 6 ) - sx * sx;
+    num   = n * pred->sxy - sx * pred->sy;
+    if( num <= 0 )
+    {
+        return THERMO8_PRED_NEVER;
+    }
+
+    // n * denom * ( limit - fitted value at the newest sample )
+    diff = n * denom * limit - ( pred->sy * denom + num * ( n * ( n - 1 ) - sx ) );
+    if( diff <= 0 )
+    {
+        return 0;
+    }
+
+    c = (uint32_t)( n * num );
+    samples = (uint32_t)diff / c;
+    // samples * periodMs plus a fraction of one period must fit 32 bits
+    if( samples >= 0xFFFFFFFF / pred->periodMs )
+    {
+        return THERMO8_PRED_NEVER - 1;
+    }
+    ms  = samples * pred->periodMs;
+    ms += _mulDiv( (uint32_t)diff % c, pred->periodMs, c, &rem );
+    if( ms / 1000 >= THERMO8_PRED_NEVER )
+    {
+        return THERMO8_PRED_NEVER - 1;
+    }
+
+    return (uint16_t)( ms / 1000 );
 }
 
-void thermo8_writeReg(uint8_t rAddr, uint16_t rData)
+#ifdef __THERMO8_BUS_SOFT__
+/*
+  Software I2C. Lines are open drain, set( 1 ) releases and get() returns
+  the line level. Bit clocking is unrolled, one pin write per edge.
+*/
+#define _SW_HALF()          Delay_us( THERMO8_SOFT_HALF_US )
+
+#define _SW_BIT_OUT(b, m)   hal_gpio_sdaSet( ( (b) & (m) ) ? 1 : 0 ); _SW_HALF(); \
+                            err |= _swSclHigh(); _SW_HALF(); hal_gpio_sclSet( 0 )
+
+#define _SW_BIT_IN(v)       _SW_HALF(); err |= _swSclHigh(); \
+                            v = ( v << 1 ) | ( hal_gpio_sdaGet() ? 1 : 0 ); \
+                            _SW_HALF(); hal_gpio_sclSet( 0 )
+
+// start condition already on the bus, set by _swStart()
+static uint8_t _swStarted;
+
+// releases SCL and waits while the slave stretches the clock, each poll
+// after the first one takes at least 1 us
+static int _swSclHigh()
 {
-   uint8_t rBuf[3];
-   rBuf[0] = rAddr;
-   rBuf[1] = (uint8_t)((rData>>8) & 0xFF);
-   rBuf[2] = (uint8_t)(rData & 0xFF);
-   hal_i2cStart();
-   hal_i2cWrite(_slaveAddress,rBuf,3,END_MODE_STOP);
+    uint16_t us = THERMO8_SOFT_STRETCH;
+
+    hal_gpio_sclSet( 1 );
+    while( !hal_gpio_sclGet() )
+    {
+        if( us-- == 0 )
+        {
+            return 1;
+        }
+        Delay_us( 1 );
+    }
+
+    return 0;
 }
 
-uint16_t thermo8_readReg(uint8_t rAddr)
+// start or repeated start, leaves SCL low. A repeated start follows an
+// ACK clock, SCL has to stay low for a half bit before it is released
+static int _swStartCond()
 {
-  uint8_t rBuf[3];
-  rBuf[0] = rAddr;
-  hal_i2cStart();
-  hal_i2cWrite(_slaveAddress,rBuf,1,END_MODE_RESTART);
-  hal_i2cRead(_slaveAddress,rBuf,2,END_MODE_STOP);
+    int err;
+
+    hal_gpio_sdaSet( 1 );
+    _SW_HALF();
+    err = _swSclHigh();
+    _SW_HALF();
+    hal_gpio_sdaSet( 0 );
+    _SW_HALF();
+    hal_gpio_sclSet( 0 );
 
-  return ( (uint16_t)rBuf[0]<<8 | rBuf[1] ) ;
+    return err;
 }
 
-void thermo8_writeReg8(uint8_t rAddr, uint8_t rData)
+static void _swStopCond()
 {
-   uint8_t rBuf[3];
-   rBuf[0] = rAddr;
-   rBuf[1] = rData;
-   hal_i2cStart();
-   hal_i2cWrite(_slaveAddress,rBuf,2,END_MODE_STOP);
+    hal_gpio_sdaSet( 0 );
+    _SW_HALF();
+    _swSclHigh();
+    _SW_HALF();
+    hal_gpio_sdaSet( 1 );
+    _SW_HALF();
 }
-uint8_t thermo8_readReg8(uint8_t rAddr)
+
+// 0 - ACK, 1 - NACK, 2 - clock stretch timeout
+static int _swByteOut(uint8_t b)
+{
+    int err = 0;
+    uint8_t nack;
+
+    _SW_BIT_OUT( b, 0x80 );
+    _SW_BIT_OUT( b, 0x40 );
+    _SW_BIT_OUT( b, 0x20 );
+    _SW_BIT_OUT( b, 0x10 );
+    _SW_BIT_OUT( b, 0x08 );
+    _SW_BIT_OUT( b, 0x04 );
+    _SW_BIT_OUT( b, 0x02 );
+    _SW_BIT_OUT( b, 0x01 );
+
+    hal_gpio_sdaSet( 1 );
+    _SW_HALF();
+    err |= _swSclHigh();
+    nack = hal_gpio_sdaGet() ? 1 : 0;
+    _SW_HALF();
+    hal_gpio_sclSet( 0 );
+
+    return err ? 2 : nack;
+}
+
+// 0 - OK, 2 - clock stretch timeout
+static int _swByteIn(uint8_t *b, uint8_t ack)
 {
-  uint8_t rBuf[2];
-  rBuf[0] = rAddr;
-  hal_i2cStart();
-  hal_i2cWrite(_slaveAddress,rBuf,1,END_MODE_RESTART);
-  hal_i2cRead(_slaveAddress,rBuf,1,END_MODE_STOP);
+    int err = 0;
+    uint8_t v = 0;
 
-  return rBuf[0];
+    hal_gpio_sdaSet( 1 );
+    _SW_BIT_IN( v );
+    _SW_BIT_IN( v );
+    _SW_BIT_IN( v );
+    _SW_BIT_IN( v );
+    _SW_BIT_IN( v );
+    _SW_BIT_IN( v );
+    _SW_BIT_IN( v );
+    _SW_BIT_IN( v );
+
+    hal_gpio_sdaSet( ack ? 0 : 1 );
+    _SW_HALF();
+    err |= _swSclHigh();
+    _SW_HALF();
+    hal_gpio_sclSet( 0 );
+    *b = v;
+
+    return err ? 2 : 0;
 }
 
-float thermo8_getTemperatue()
+// nine clocks release a slave stuck in a read, then STOP, no stretching wait
+static uint16_t _swRecover()
 {
-  float tTemp;
-  uint16_t tData;
+    uint8_t i;
 
-  tData=thermo8_readReg(THERMO8_TA);
-  thermo8Limitstatus = tData;
-  tTemp = _btoTconversion(tData);
-  return tTemp;
+    _swStarted = 0;
+    hal_gpio_sdaSet( 1 );
+    for( i = 0; ( i < 9 ) && !hal_gpio_sdaGet(); i++ )
+    {
+        hal_gpio_sclSet( 0 );
+        _SW_HALF();
+        hal_gpio_sclSet( 1 );
+        _SW_HALF();
+    }
+    hal_gpio_sclSet( 0 );
+    hal_gpio_sdaSet( 0 );
+    _SW_HALF();
+    hal_gpio_sclSet( 1 );
+    _SW_HALF();
+    hal_gpio_sdaSet( 1 );
+    _SW_HALF();
+
+    return ( 2 * i + 3 ) * THERMO8_SOFT_HALF_US;
 }
 
-void thermo8_setResolution(uint8_t rCfg)
+static int _swStart()
 {
-   uint8_t tmp;
+    _swStarted = 1;
 
-   tmp = rCfg & 0x03;
-   thermo8_writeReg8(THERMO8_RESOLUTION_REG,rCfg);
+    return _swStartCond();
 }
 
-uint16_t thermo8_getDevid()
+static int _swWrite(uint8_t slave, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
 {
-   return thermo8_readReg(THERMO8_DEVID);
+    int err = 0;
+    uint16_t i;
+
+    if( !_swStarted )
+    {
+        err = _swStartCond();
+    }
+    _swStarted = 0;
+
+    if( !err )
+    {
+        err = _swByteOut( slave << 1 );
+    }
+    for( i = 0; ( i < nBytes ) && !err; i++ )
+    {
+        err = _swByteOut( pBuf[ i ] );
+    }
+    if( err || ( endMode == END_MODE_STOP ) )
+    {
+        _swStopCond();
+    }
+
+    return err;
 }
 
-uint16_t thermo8_getManid()
+static int _swRead(uint8_t slave, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
+{
+    int err = 0;
+    uint16_t i;
+
+    // a read always follows a restart or a fresh start
+    if( !_swStarted )
+    {
+        err = _swStartCond();
+    }
+    _swStarted = 0;
+
+    if( !err )
+    {
+        err = _swByteOut( ( slave << 1 ) | 0x01 );
+    }
+    for( i = 0; ( i < nBytes ) && !err; i++ )
+    {
+        err = _swByteIn( &pBuf[ i ], i + 1 < nBytes );
+    }
+    if( err || ( endMode == END_MODE_STOP ) )
+    {
+        _swStopCond();
+    }
+
+    return err;
+}
+#endif
+
+// on error, 1 when the transaction should be attempted again
+static uint8_t _busRetry(uint8_t *tries, uint8_t retries)
 {
-   return thermo8_readReg(THERMO8_MANID);
+    _busStats.errors++;
+    if( *tries >= retries )
+    {
+        _busStats.failures++;
+        return 0;
+    }
+    (*tries)++;
+    _busStats.retries++;
+    thermo8_busRecover();
+
+    return 1;
 }
 
-void thermo8_sleep()
+/*
+  Register transactions with up to retries extra attempts. The caller holds
+  the bus lock, _read16() and friends wrap them with the lock and the
+  budget set by thermo8_retrySet().
+*/
+static int _read16n(uint8_t slave, uint8_t rAddr, uint16_t *rData, uint8_t retries)
 {
-  uint16_t tmp;
-  
-  tmp = thermo8_readReg(THERMO8_CONFIG);
-  tmp |= 1<<8;
-  thermo8_writeReg(THERMO8_CONFIG,tmp);                                         //wait for the device to gi ti skeeo
-  Delay_100ms();
+    uint8_t rBuf[2];
+    uint8_t tries = 0;
+    int err;
+
+    do
+    {
+        rBuf[0] = rAddr;
+        err = THERMO8_BUS_START();
+        if( !err )
+        {
+            err = THERMO8_BUS_WRITE(slave,rBuf,1,END_MODE_RESTART);
+        }
+        if( !err )
+        {
+            err = THERMO8_BUS_READ(slave,rBuf,2,END_MODE_STOP);
+        }
+    }
+    while( err && _busRetry( &tries, retries ) );
+    if( !err )
+    {
+        *rData = (uint16_t)rBuf[0]<<8 | rBuf[1];
+        _cacheStore( slave, rAddr, *rData );
+    }
+
+    return err;
 }
 
-void thermo8_wakeup()
+static int _read8n(uint8_t slave, uint8_t rAddr, uint8_t *rData, uint8_t retries)
 {
-  uint16_t tmp;
+    uint8_t rBuf;
+    uint8_t tries = 0;
+    int err;
+
+    do
+    {
+        rBuf = rAddr;
+        err = THERMO8_BUS_START();
+        if( !err )
+        {
+            err = THERMO8_BUS_WRITE(slave,&rBuf,1,END_MODE_RESTART);
+        }
+        if( !err )
+        {
+            err = THERMO8_BUS_READ(slave,&rBuf,1,END_MODE_STOP);
+        }
+    }
+    while( err && _busRetry( &tries, retries ) );
+    if( !err )
+    {
+        *rData = rBuf;
+        _cacheStore( slave, rAddr, *rData );
+    }
 
-  tmp = thermo8_readReg(THERMO8_CONFIG);
-  tmp &= ~( 1<<8 );
-  thermo8_writeReg(THERMO8_CONFIG,tmp);
-  Delay_100ms();                                                                //wait for the device to wakeup
+    return err;
 }
 
-void thermo8_limitSet(uint8_t limitRegaddr, float limit)
+static int _write16n(uint8_t slave, uint8_t rAddr, uint16_t rData, uint8_t retries)
 {
-    float climit;
-    uint16_t xlimit;
-    
-    climit = (limit * 16.0);
-    xlimit = (uint16_t)climit;
-    
-    if(xlimit & 0x03)
+    uint8_t rBuf[3];
+    uint8_t tries = 0;
+    int err;
+
+    do
     {
-       xlimit +=1;
+        rBuf[0] = rAddr;
+        rBuf[1] = (uint8_t)((rData>>8) & 0xFF);
+        rBuf[2] = (uint8_t)(rData & 0xFF);
+        err = THERMO8_BUS_START();
+        if( !err )
+        {
+            err = THERMO8_BUS_WRITE(slave,rBuf,3,END_MODE_STOP);
+        }
     }
-    
-    thermo8_writeReg(limitRegaddr,xlimit);
+    while( err && _busRetry( &tries, retries ) );
+    if( !err )
+    {
+        _cacheStore( slave, rAddr, rData );
+    }
+
+    return err;
 }
 
-uint8_t thermo8_getAlertstat()
+static int _write8n(uint8_t slave, uint8_t rAddr, uint8_t rData, uint8_t retries)
 {
-    uint8_t alertGen = 0;
-    if(thermo8Limitstatus & 1<<13)
+    uint8_t rBuf[2];
+    uint8_t tries = 0;
+    int err;
+
+    do
     {
-      alertGen |= THERMO8_TLOWER_REACHED;
+        rBuf[0] = rAddr;
+        rBuf[1] = rData;
+        err = THERMO8_BUS_START();
+        if( !err )
+        {
+            err = THERMO8_BUS_WRITE(slave,rBuf,2,END_MODE_STOP);
+        }
     }
-    if(thermo8Limitstatus & 1<<14)
+    while( err && _busRetry( &tries, retries ) );
+    if( !err )
     {
-      alertGen |= THERMO8_TUPPER_REACHED;
+        _cacheStore( slave, rAddr, rData );
     }
-    if(thermo8Limitstatus & 1<<15)
+
+    return err;
+}
+
+static int _read16(uint8_t slave, uint8_t rAddr, uint16_t *rData)
+{
+    int err;
+
+    _busLock();
+    err = _read16n( slave, rAddr, rData, _retries );
+    _busUnlock();
+
+    return err;
+}
+
+static int _read8(uint8_t slave, uint8_t rAddr, uint8_t *rData)
+{
+    int err;
+
+    _busLock();
+    err = _read8n( slave, rAddr, rData, _retries );
+    _busUnlock();
+
+    return err;
+}
+
+static int _write16(uint8_t slave, uint8_t rAddr, uint16_t rData)
+{
+    int err;
+
+    _busLock();
+    err = _write16n( slave, rAddr, rData, _retries );
+    _busUnlock();
+
+    return err;
+}
+
+static int _write8(uint8_t slave, uint8_t rAddr, uint8_t rData)
+{
+    int err;
+
+    _busLock();
+    err = _write8n( slave, rAddr, rData, _retries );
+    _busUnlock();
+
+    return err;
+}
+
+// bus lock hooks, held for exactly one transaction
+static void _busLock()
+{
+    if( _lockFp )
     {
-      alertGen |= THERMO8_TCRIT_REACHED;
+        _lockFp();
     }
-    
-    return alertGen;
 }
 
-void thermo8_alertEnable(uint8_t thys, uint8_t alertCfg)
+static void _busUnlock()
 {
-     uint16_t cfg;
-     // Int_out | AlertCnt
-     cfg = 0x0001 | 0x0008 | 0x0010 ;
-     thys &= 0x03;
-     if(THERMO8_TCRIT_ONLY_ALERT == alertCfg)
-     {
-        cfg |= 0x0004;
-     }
-     else
-     {
-       cfg &= ~0x0004;
-     }
-     cfg |= (thys<<9);
-     thermo8_writeReg(THERMO8_CONFIG,cfg);
+    if( _unlockFp )
+    {
+        _unlockFp();
+    }
+}
+
+// alert flags indexed by TA bits 15..13 ( CRIT, UPPER, LOWER )
+static const uint8_t _flagLut[ 8 ] = { 0x00, 0x0C, 0x03, 0x0F, 0x30, 0x3C, 0x33, 0x3F };
+
+static uint8_t _alertFlags(uint16_t status)
+{
+    return _flagLut[ status >> 13 ];
+}
+
+// same mapping without the table lookup, for the vectorized batch loops
+static uint8_t _alertFlagsBits(uint16_t status)
+{
+    return (uint8_t)( ( ( status >> 13 ) & 0x01 ) * 0x0C | ( ( status >> 14 ) & 0x01 ) * 0x03 |
+                      ( status >> 15 ) * 0x30 );
+}
+
+static void _cacheStore(uint8_t slave, uint8_t rAddr, uint16_t rData)
+{
+    uint8_t idx;
+    T_thermo8_regCache *cache;
+
+    if( ( slave < THERMO8_ADDR_BASE ) || ( slave > THERMO8_ADDR_LAST ) || _muxOpen )
+    {
+        return;
+    }
+    if( ( rAddr >= THERMO8_REG_CONFIG ) && ( rAddr <= THERMO8_REG_TCRIT ) )
+    {
+        idx = rAddr - THERMO8_REG_CONFIG;
+    }
+    else if( rAddr == THERMO8_REG_RESOLUTION )
+    {
+        idx = 4;
+    }
+    else
+    {
+        return;
+    }
+    cache = &_regCache[ slave - THERMO8_ADDR_BASE ];
+    cache->reg[ idx ] = rData;
+    cache->valid |= 1 << idx;
+}
+
+// 1/16 C code to limit register word, rounded to the nearest 0.25 C with
+// ties away from zero like thermo8_limitSet()
+static uint16_t _codeToLimit(int16_t code)
+{
+    int16_t q;
+
+    if( code >= 0 )
+    {
+        q = ( code + 2 ) / 4;
+    }
+    else
+    {
+        q = -( ( -code + 2 ) / 4 );
+    }
+    if( q > 1023 )
+    {
+        q = 1023;
+    }
+    if( q < -1024 )
+    {
+        q = -1024;
+    }
+
+    return THERMO8_LIMIT( q );
 }
 
-void thermo8_tcritLock()
+static int16_t _calApply(const T_thermo8_cal *cal, int16_t code)
 {
-     uint16_t tmp;
-     tmp=thermo8_readReg(THERMO8_CONFIG);
-     tmp |= 1<<7;
-     thermo8_writeReg(THERMO8_CONFIG,tmp);
+    if( !cal->gain )
+    {
+        return code;
+    }
+    return (int16_t)( ( (int32_t)code * cal->gain + 0x2000 ) >> 14 ) + cal->offset;
 }
 
-void thermo8_tcritUnlock()
+static int16_t _calFwd(uint8_t slave, int16_t code)
 {
-     uint16_t tmp;
-     tmp=thermo8_readReg(THERMO8_CONFIG);
-     tmp &= ~(1<<7);
-     thermo8_writeReg(THERMO8_CONFIG,tmp);
+    if( ( slave < THERMO8_ADDR_BASE ) || ( slave > THERMO8_ADDR_LAST ) )
+    {
+        return code;
+    }
+    return _calApply( &_cal[ slave - THERMO8_ADDR_BASE ], code );
 }
 
-void thermo8_winLock()
+// calibrated temperature to the sensor reading producing it, rounded
+static int16_t _calRev(uint8_t slave, int16_t code)
 {
-     uint16_t tmp;
-     tmp=thermo8_readReg(THERMO8_CONFIG);
-     tmp |= 1<<6;
-     thermo8_writeReg(THERMO8_CONFIG,tmp);
+    T_thermo8_cal *cal;
+    int32_t num;
+    int32_t q;
+
+    if( ( slave < THERMO8_ADDR_BASE ) || ( slave > THERMO8_ADDR_LAST ) )
+    {
+        return code;
+    }
+    cal = &_cal[ slave - THERMO8_ADDR_BASE ];
+    if( !cal->gain )
+    {
+        return code;
+    }
+    num = ( (int32_t)code - cal->offset ) * 16384;
+    if( num >= 0 )
+    {
+        q = ( num + cal->gain / 2 ) / cal->gain;
+    }
+    else
+    {
+        q = -( ( -num + cal->gain / 2 ) / cal->gain );
+    }
+    // far outside the sensor range, _codeToLimit clamps further
+    if( q > 0x3FFF )
+    {
+        q = 0x3FFF;
+    }
+    if( q < -0x4000 )
+    {
+        q = -0x4000;
+    }
+
+    return (int16_t)q;
 }
 
-void thermo8_winUnlock()
+// sorts v in place, even counts average the middle pair
+static int16_t _median(int16_t *v, uint8_t n)
 {
-     uint16_t tmp;
-     tmp=thermo8_readReg(THERMO8_CONFIG);
-     tmp &= ~(1<<6);
-     thermo8_writeReg(THERMO8_CONFIG,tmp);
+    int16_t x;
+    uint8_t i;
+    uint8_t j;
+
+    for( i = 1; i < n; i++ )
+    {
+        x = v[ i ];
+        for( j = i; ( j > 0 ) && ( v[ j - 1 ] > x ); j-- )
+        {
+            v[ j ] = v[ j - 1 ];
+        }
+        v[ j ] = x;
+    }
+    if( n & 0x01 )
+    {
+        return v[ n / 2 ];
+    }
+    return (int16_t)( ( (int32_t)v[ n / 2 - 1 ] + v[ n / 2 ] ) >> 1 );
 }
 
+static void _profileImage(uint8_t slave, const T_thermo8_profile *profile, uint16_t *img)
+{
+    // same CONFIG layout as thermo8_alertEnable(), locks on top
+    img[ 0 ] = THERMO8_CFG_ALERT_MOD | THERMO8_CFG_ALERT_CNT | THERMO8_CFG_ALERT_STAT |
+               THERMO8_CFG_THYS( profile->hysteresis );
+    if( THERMO8_TCRIT_ONLY_ALERT == profile->alertMode )
+    {
+        img[ 0 ] |= THERMO8_CFG_ALERT_SEL;
+    }
+    if( profile->locks & THERMO8_LOCK_CRIT )
+    {
+        img[ 0 ] |= THERMO8_CFG_CRIT_LOCK;
+    }
+    if( profile->locks & THERMO8_LOCK_WIN )
+    {
+        img[ 0 ] |= THERMO8_CFG_WIN_LOCK;
+    }
+    img[ 1 ] = _codeToLimit( _calRev( slave, profile->tUpper ) );
+    img[ 2 ] = _codeToLimit( _calRev( slave, profile->tLower ) );
+    img[ 3 ] = _codeToLimit( _calRev( slave, profile->tCrit ) );
+    img[ 4 ] = THERMO8_RES( profile->resolution );
+}
+
+// stops at the first failed write, the cache only follows successful writes
+static int _profileApply(uint8_t slave, const T_thermo8_profile *profile)
+{
+    uint16_t img[ 5 ];
+    uint16_t cfg;
+    uint16_t lock;
+    uint16_t rData;
+    uint8_t  i;
+    int err;
+    T_thermo8_regCache *cache;
+
+    cache = &_regCache[ slave - THERMO8_ADDR_BASE ];
+    _profileImage( slave, profile, img );
+
+    if( cache->valid & 0x01 )
+    {
+        cfg = cache->reg[ 0 ];
+    }
+    else
+    {
+        err = _read16( slave, THERMO8_REG_CONFIG, &cfg );
+        if( err )
+        {
+            return err;
+        }
+    }
+
+    if( !( ( cache->valid & 0x10 ) && ( cache->reg[ 4 ] == img[ 4 ] ) ) )
+    {
+        err = _write8( slave, THERMO8_REG_RESOLUTION, (uint8_t)img[ 4 ] );
+        if( err )
+        {
+            return err;
+        }
+    }
+    for( i = 1; i < 4; i++ )
+    {
+        if( ( cache->valid & ( 1 << i ) ) && ( cache->reg[ i ] == img[ i ] ) )
+        {
+            continue;
+        }
+        // a locked limit ACKs the write and keeps its value, it has to match
+        lock = ( i == 3 ) ? THERMO8_CFG_CRIT_LOCK : THERMO8_CFG_WIN_LOCK;
+        if( cfg & lock )
+        {
+            err = _read16( slave, THERMO8_REG_CONFIG + i, &rData );
+            if( err )
+            {
+                return err;
+            }
+            if( rData != img[ i ] )
+            {
+                return THERMO8_ERR_LOCKED;
+            }
+            continue;
+        }
+        err = _write16( slave, THERMO8_REG_CONFIG + i, img[ i ] );
+        if( err )
+        {
+            return err;
+        }
+    }
+    if( !( ( cache->valid & 0x01 ) &&
+           ( ( cache->reg[ 0 ] ^ img[ 0 ] ) & _THERMO8_CFG_CMP_MASK ) == 0 ) )
+    {
+        err = _write16( slave, THERMO8_REG_CONFIG, img[ 0 ] );
+        if( err )
+        {
+            return err;
+        }
+        if( cfg & ( THERMO8_CFG_CRIT_LOCK | THERMO8_CFG_WIN_LOCK ) )
+        {
+            // locks and alert bits did not take the image, read it back next time
+            cache->valid &= ~0x01;
+        }
+    }
+
+    return 0;
+}
+
+// 0 when the limit register holds rData after the call
+static uint8_t _limitProgram(uint8_t slave, uint8_t rAddr, uint16_t rData, uint8_t locked)
+{
+    uint16_t cur;
+    T_thermo8_regCache *cache;
+
+    cache = &_regCache[ slave - THERMO8_ADDR_BASE ];
+    if( cache->valid & ( 1 << ( rAddr - THERMO8_REG_CONFIG ) ) )
+    {
+        cur = cache->reg[ rAddr - THERMO8_REG_CONFIG ];
+    }
+    else if( _read16( slave, rAddr, &cur ) )
+    {
+        return 1;
+    }
+    if( cur == rData )
+    {
+        return 0;
+    }
+    if( locked )
+    {
+        return 1;
+    }
+    if( _write16( slave, rAddr, rData ) || _read16( slave, rAddr, &cur ) )
+    {
+        return 1;
+    }
+
+    return cur != rData;
+}
+
+// returns 1 and records the revision when a MCP9808 answers at slave
+// single attempt, absent addresses are the normal case here
+static uint8_t _probe(uint8_t slave, uint8_t verifyManid)
+{
+    uint16_t id;
+    uint8_t found = 0;
+
+    _busLock();
+    if( !_read16n( slave, THERMO8_REG_DEVID, &id, 0 ) && ( ( id >> 8 ) == 0x04 ) )
+    {
+        _inventory.revision[ slave - THERMO8_ADDR_BASE ] = (uint8_t)id;
+        found = !verifyManid ||
+                ( !_read16n( slave, THERMO8_REG_MANID, &id, 0 ) && ( id == 0x0054 ) );
+    }
+    _busUnlock();
+
+    return found;
+}
+
+static void _taskXferDone(T_thermo8_xfer *xfer)
+{
+    xfer->tag = 1;
+}
+
+static void _taskSubmit(T_thermo8_task *task, uint8_t rAddr, uint8_t write, uint16_t rData)
+{
+    task->xfer.slave  = task->dev.slave;
+    task->xfer.rAddr  = rAddr;
+    task->xfer.nBytes = 2;
+    task->xfer.write  = write;
+    task->xfer.buf[0] = (uint8_t)( rData >> 8 );
+    task->xfer.buf[1] = (uint8_t)rData;
+    task->xfer.err    = 0;
+    task->xfer.tag    = 0;
+    task->xfer.cb     = _taskXferDone;
+    if( thermo8_asyncSubmit( &task->xfer ) )
+    {
+        // queue full, retried on the next step
+        task->xfer.tag = 2;
+    }
+}
+
+// records the transaction error, the await stops the task
+static uint8_t _taskFail(T_thermo8_task *task)
+{
+    if( !task->dev.err )
+    {
+        task->dev.err = task->xfer.err;
+    }
+    task->op = 0;
+
+    return 2;
+}
+
+// the mux functions below expect the bus lock to be held by the caller
+static int _muxWrite(uint8_t m, uint8_t ctl)
+{
+    uint8_t tries = 0;
+    int err;
+    uint8_t i;
+
+    do
+    {
+        err = THERMO8_BUS_START();
+        if( !err )
+        {
+            err = THERMO8_BUS_WRITE(THERMO8_MUX_BASE | m,&ctl,1,END_MODE_STOP);
+        }
+    }
+    while( err && _busRetry( &tries, _retries ) );
+    if( !err )
+    {
+        _muxKnown |= 1 << m;
+        _muxChan[ m ] = ctl;
+    }
+    else if( ( _muxKnown & ( 1 << m ) ) && _muxChan[ m ] )
+    {
+        // a channel may still be open, matches no selection and gets closed
+        _muxChan[ m ] = 0xFF;
+    }
+
+    // a failed write leaves the channels unknown, treat them as open
+    _muxOpen = err ? 1 : 0;
+    for( i = 0; i < 8; i++ )
+    {
+        if( ( _muxKnown & ( 1 << i ) ) && _muxChan[ i ] )
+        {
+            _muxOpen = 1;
+        }
+    }
+
+    return err;
+}
+
+// other multiplexers are closed first, nothing is selected if that fails
+static int _muxSelect(uint8_t mux, uint8_t channel)
+{
+    uint8_t ctl;
+    uint8_t m;
+    uint8_t i;
+    int err;
+
+    m   = mux & 0x07;
+    ctl = ( channel < 8 ) ? ( 1 << channel ) : 0;
+    if( ( _muxKnown & ( 1 << m ) ) && ( _muxChan[ m ] == ctl ) )
+    {
+        return 0;
+    }
+    for( i = 0; i < 8; i++ )
+    {
+        if( ( i != m ) && ( _muxKnown & ( 1 << i ) ) && _muxChan[ i ] )
+        {
+            err = _muxWrite( i, 0 );
+            if( err )
+            {
+                return err;
+            }
+        }
+    }
+
+    return _muxWrite( m, ctl );
+}
+
+static int _muxRelease()
+{
+    uint8_t i;
+    int err = 0;
+    int e;
+
+    for( i = 0; i < 8; i++ )
+    {
+        if( ( _muxKnown & ( 1 << i ) ) && _muxChan[ i ] )
+        {
+            e = _muxWrite( i, 0 );
+            if( !err )
+            {
+                err = e;
+            }
+        }
+    }
+
+    return err;
+}
+
+// routes the bus to dev and runs one register transaction under one lock
+static int _muxXfer(T_thermo8_muxDev *dev, uint8_t rAddr, uint16_t *rData, uint8_t write, uint8_t retries)
+{
+    int err;
+
+    _busLock();
+    err = dev->mux ? _muxSelect( dev->mux, dev->channel ) : _muxRelease();
+    if( !err )
+    {
+        err = write ? _write16n( dev->slave, rAddr, *rData, retries ) :
+                      _read16n( dev->slave, rAddr, rData, retries );
+    }
+    _busUnlock();
+    dev->err = (uint8_t)err;
+
+    return err;
+}
+
+// sort key, direct devices first, then multiplexer, channel and address
+static uint16_t _muxKey(const T_thermo8_muxDev *dev)
+{
+    uint16_t key;
+
+    key = dev->mux ? ( ( dev->mux & 0x07 ) + 1 ) : 0;
+
+    return ( key << 10 ) | ( ( dev->channel & 0x07 ) << 7 ) | ( dev->slave & 0x7F );
+}
+
+// sets or clears SHDN, CONFIG comes from the cache when possible
+static int _shdnSet(uint8_t slave, uint8_t shdn)
+{
+    T_thermo8_regCache *cache;
+    uint16_t cfg;
+
+    cache = &_regCache[ slave - THERMO8_ADDR_BASE ];
+    if( cache->valid & 0x01 )
+    {
+        cfg = cache->reg[ 0 ];
+    }
+    else if( _read16( slave, THERMO8_REG_CONFIG, &cfg ) )
+    {
+        return 1;
+    }
+    cfg &= _THERMO8_CFG_CMP_MASK;
+    if( shdn )
+    {
+        cfg |= THERMO8_CFG_SHDN;
+    }
+    else
+    {
+        cfg &= ~THERMO8_CFG_SHDN;
+    }
+
+    return _write16( slave, THERMO8_REG_CONFIG, cfg );
+}
+
+// CONFIG read-modify-write of the legacy calls, nothing is written after a
+// failed read
+static int _cfgUpdate(uint16_t clr, uint16_t set)
+{
+    uint16_t cfg;
+    int err;
+
+    err = _read16( _dev.slave, THERMO8_REG_CONFIG, &cfg );
+    if( !err )
+    {
+        err = _write16( _dev.slave, THERMO8_REG_CONFIG, ( cfg & ~clr ) | set );
+    }
+    if( !_dev.err )
+    {
+        _dev.err = err;
+    }
+
+    return err;
+}
+
+// worst case when the resolution is not cached
+static uint16_t _convTime(uint8_t slave)
+{
+    T_thermo8_regCache *cache;
+
+    if( ( slave < THERMO8_ADDR_BASE ) || ( slave > THERMO8_ADDR_LAST ) )
+    {
+        return _convMs[ 3 ];
+    }
+    cache = &_regCache[ slave - THERMO8_ADDR_BASE ];
+    if( cache->valid & 0x10 )
+    {
+        return _convMs[ cache->reg[ 4 ] & 0x03 ];
+    }
+    return _convMs[ 3 ];
+}
+
+/* --------------------------------------------------------- PUBLIC FUNCTIONS */
+#ifdef   __THERMO8_DRV_I2C__
+
+void thermo8_i2cDriverInit(T_THERMO8_P gpioObj, T_THERMO8_P i2cObj, uint8_t slave)
+{
+    _dev.slave = slave;
+    hal_i2cMap( (T_HAL_P)i2cObj );
+    hal_gpioMap( (T_HAL_P)gpioObj );
+#ifdef __THERMO8_BUS_SOFT__
+    hal_gpio_sclSet( 1 );
+    hal_gpio_sdaSet( 1 );
+#endif
+}
+
+#endif
+/* ----------------------------------------------------------- IMPLEMENTATION */
+uint8_t thermo8_aleGet()
+{
+    return THERMO8_INT_GET();
+}
+
+int thermo8_writeReg(uint8_t rAddr, uint16_t rData)
+{
+  int err;
+
+  err = _write16(_dev.slave,rAddr,rData);
+  if( !_dev.err )
+  {
+    _dev.err = err;
+  }
+  return err;
+}
+
+uint16_t thermo8_readReg(uint8_t rAddr)
+{
+  uint16_t rData = 0;
+  int err;
+
+  err = _read16(_dev.slave,rAddr,&rData);
+  if( !_dev.err )
+  {
+    _dev.err = err;
+  }
+  return rData;
+}
+
+int thermo8_writeReg8(uint8_t rAddr, uint8_t rData)
+{
+  int err;
+
+  err = _write8(_dev.slave,rAddr,rData);
+  if( !_dev.err )
+  {
+    _dev.err = err;
+  }
+  return err;
+}
+uint8_t thermo8_readReg8(uint8_t rAddr)
+{
+  uint8_t rData = 0;
+  int err;
+
+  err = _read8(_dev.slave,rAddr,&rData);
+  if( !_dev.err )
+  {
+    _dev.err = err;
+  }
+  return rData;
+}
+
+float thermo8_getTemperatue()
+{
+  float tTemp;
+  uint16_t tData;
+
+  tData=thermo8_readReg(THERMO8_REG_TA);
+  _dev.status = tData;
+  tTemp = (float)_calFwd(_dev.slave,_rawToCode(tData)) / 16.0;
+  return tTemp;
+}
+
+void thermo8_setResolution(uint8_t rCfg)
+{
+   thermo8_writeReg8(THERMO8_REG_RESOLUTION,THERMO8_RES( rCfg ));
+}
+
+uint16_t thermo8_getDevid()
+{
+   return thermo8_readReg(THERMO8_REG_DEVID);
+}
+
+uint16_t thermo8_getManid()
+{
+   return thermo8_readReg(THERMO8_REG_MANID);
+}
+
+int thermo8_sleep()
+{
+  int err;
+
+  err = _cfgUpdate(0,THERMO8_CFG_SHDN);
+  if( !err )
+  {
+    Delay_100ms();                                                              //wait for the device to go to sleep
+  }
+  return err;
+}
+
+int thermo8_wakeup()
+{
+  int err;
+
+  err = _cfgUpdate(THERMO8_CFG_SHDN,0);
+  if( !err )
+  {
+    Delay_100ms();                                                              //wait for the device to wakeup
+  }
+  return err;
+}
+
+void thermo8_limitSet(uint8_t limitRegaddr, float limit)
+{
+    float climit;
+    int16_t xlimit;
+
+    climit = (limit * 4.0);
+    if( climit > 1023.0 )
+    {
+       climit = 1023.0;
+    }
+    if( climit < -1024.0 )
+    {
+       climit = -1024.0;
+    }
+    if( climit >= 0 )
+    {
+       xlimit = (int16_t)( climit + 0.5 );
+    }
+    else
+    {
+       xlimit = -(int16_t)( -climit + 0.5 );
+    }
+
+    thermo8_limitSetQ2(limitRegaddr,xlimit);
+}
+
+uint8_t thermo8_getAlertstat()
+{
+    return _alertFlags(_dev.status);
+}
+
+void thermo8_alertEnable(uint8_t thys, uint8_t alertCfg)
+{
+     uint16_t cfg;
+     cfg = THERMO8_CFG_ALERT_MOD | THERMO8_CFG_ALERT_CNT | THERMO8_CFG_ALERT_STAT;
+     thys &= 0x03;
+     if(THERMO8_TCRIT_ONLY_ALERT == alertCfg)
+     {
+        cfg |= THERMO8_CFG_ALERT_SEL;
+     }
+     else
+     {
+       cfg &= ~THERMO8_CFG_ALERT_SEL;
+     }
+     cfg |= THERMO8_CFG_THYS( thys );
+     thermo8_writeReg(THERMO8_REG_CONFIG,cfg);
+}
+
+int thermo8_tcritLock()
+{
+     return _cfgUpdate(0,THERMO8_CFG_CRIT_LOCK);
+}
+
+int thermo8_tcritUnlock()
+{
+     return _cfgUpdate(THERMO8_CFG_CRIT_LOCK,0);
+}
+
+int thermo8_winLock()
+{
+     return _cfgUpdate(0,THERMO8_CFG_WIN_LOCK);
+}
+
+int thermo8_winUnlock()
+{
+     return _cfgUpdate(THERMO8_CFG_WIN_LOCK,0);
+}
+
+void thermo8_limitSetQ2(uint8_t limitRegaddr, int16_t quarters)
+{
+    if( quarters > 1023 )
+    {
+        quarters = 1023;
+    }
+    if( quarters < -1024 )
+    {
+        quarters = -1024;
+    }
+    thermo8_writeReg( limitRegaddr, _codeToLimit( _calRev( _dev.slave, quarters * 4 ) ) );
+}
+
+void thermo8_limitSetQ4(uint8_t limitRegaddr, int16_t tRaw)
+{
+    thermo8_writeReg( limitRegaddr, _codeToLimit( _calRev( _dev.slave, tRaw ) ) );
+}
+
+uint8_t thermo8_calFromPoints(T_thermo8_cal *cal, int16_t raw1, int16_t ref1, int16_t raw2, int16_t ref2)
+{
+    int32_t d;
+    int32_t num;
+    int32_t gain;
+
+    d   = (int32_t)raw2 - raw1;
+    num = ( (int32_t)ref2 - ref1 ) * 16384;
+    if( d < 0 )
+    {
+        d   = -d;
+        num = -num;
+    }
+    // at least 1 C between the points
+    if( ( d < 16 ) || ( num <= 0 ) )
+    {
+        return 1;
+    }
+    gain = ( num + d / 2 ) / d;
+    if( gain > 0xFFFF )
+    {
+        return 1;
+    }
+    cal->gain   = (uint16_t)gain;
+    cal->offset = 0;
+    cal->offset = ref1 - _calApply( cal, raw1 );
+
+    return 0;
+}
+
+void thermo8_calSet(uint8_t slave, const T_thermo8_cal *cal)
+{
+    if( ( slave < THERMO8_ADDR_BASE ) || ( slave > THERMO8_ADDR_LAST ) )
+    {
+        return;
+    }
+    if( cal )
+    {
+        _cal[ slave - THERMO8_ADDR_BASE ] = *cal;
+    }
+    else
+    {
+        _cal[ slave - THERMO8_ADDR_BASE ].gain   = 0;
+        _cal[ slave - THERMO8_ADDR_BASE ].offset = 0;
+    }
+}
+
+void thermo8_calBatch(const T_thermo8_cal *cal, int16_t *code, uint16_t n)
+{
+    uint16_t i;
+
+    for( i = 0; i < n; i++ )
+    {
+        code[ i ] = _calApply( &cal[ i ], code[ i ] );
+    }
+}
+
+uint8_t thermo8_windowSet(int16_t tUpper, int16_t tLower, int16_t tCrit)
+{
+    uint16_t cfg;
+    uint8_t  fail = 0;
+    T_thermo8_regCache *cache;
+
+    if( ( _dev.slave < THERMO8_ADDR_BASE ) || ( _dev.slave > THERMO8_ADDR_LAST ) )
+    {
+        return THERMO8_WIN_UPPER | THERMO8_WIN_LOWER | THERMO8_WIN_CRIT;
+    }
+    cache = &_regCache[ _dev.slave - THERMO8_ADDR_BASE ];
+    if( cache->valid & 0x01 )
+    {
+        cfg = cache->reg[ 0 ];
+    }
+    else if( _read16( _dev.slave, THERMO8_REG_CONFIG, &cfg ) )
+    {
+        return THERMO8_WIN_UPPER | THERMO8_WIN_LOWER | THERMO8_WIN_CRIT;
+    }
+
+    if( _limitProgram( _dev.slave, THERMO8_REG_TUPPER, _codeToLimit( _calRev( _dev.slave, tUpper ) ),
+                       cfg & THERMO8_CFG_WIN_LOCK ) )
+    {
+        fail |= THERMO8_WIN_UPPER;
+    }
+    if( _limitProgram( _dev.slave, THERMO8_REG_TLOWER, _codeToLimit( _calRev( _dev.slave, tLower ) ),
+                       cfg & THERMO8_CFG_WIN_LOCK ) )
+    {
+        fail |= THERMO8_WIN_LOWER;
+    }
+    if( _limitProgram( _dev.slave, THERMO8_REG_TCRIT, _codeToLimit( _calRev( _dev.slave, tCrit ) ),
+                       cfg & THERMO8_CFG_CRIT_LOCK ) )
+    {
+        fail |= THERMO8_WIN_CRIT;
+    }
+
+    return fail;
+}
+
+int16_t thermo8_getTemperatureRaw()
+{
+  uint16_t tData;
+
+  tData = thermo8_readReg(THERMO8_REG_TA);
+  _dev.status = tData;
+  return _calFwd(_dev.slave,_rawToCode(tData));
+}
+
+void thermo8_groupInit(T_thermo8_group *group, const uint8_t *idx, uint8_t n, uint8_t k, int16_t madMin)
+{
+    uint8_t i;
+
+    if( n > 8 )
+    {
+        n = 8;
+    }
+    group->n      = n;
+    group->k      = k;
+    group->madMin = madMin;
+    for( i = 0; i < n; i++ )
+    {
+        group->idx[ i ] = idx[ i ];
+    }
+}
+
+uint8_t thermo8_groupEval(const T_thermo8_group *group, const int16_t *tRaw, const uint8_t *valid, T_thermo8_zone *zone)
+{
+    int16_t  val[ 8 ];
+    int16_t  dev[ 8 ];
+    int16_t  tmp[ 8 ];
+    uint8_t  member[ 8 ];
+    int32_t  sum = 0;
+    int32_t  lim;
+    uint8_t  used = 0;
+    uint8_t  n = 0;
+    uint8_t  i;
+
+    zone->outliers = 0;
+    for( i = 0; i < group->n; i++ )
+    {
+        if( valid && !valid[ group->idx[ i ] ] )
+        {
+            continue;
+        }
+        member[ n ] = i;
+        val[ n ]    = tRaw[ group->idx[ i ] ];
+        tmp[ n ]    = val[ n ];
+        n++;
+    }
+    zone->used = n;
+    if( n == 0 )
+    {
+        zone->median = 0;
+        zone->mean   = 0;
+        zone->mad    = 0;
+        return 0;
+    }
+
+    zone->median = _median( tmp, n );
+    for( i = 0; i < n; i++ )
+    {
+        dev[ i ] = val[ i ] - zone->median;
+        if( dev[ i ] < 0 )
+        {
+            dev[ i ] = -dev[ i ];
+        }
+        tmp[ i ] = dev[ i ];
+    }
+    zone->mad = _median( tmp, n );
+
+    lim = (int32_t)group->k * ( ( zone->mad > group->madMin ) ? zone->mad : group->madMin );
+    for( i = 0; i < n; i++ )
+    {
+        if( dev[ i ] > lim )
+        {
+            zone->outliers |= 1 << member[ i ];
+        }
+        else
+        {
+            sum += val[ i ];
+            used++;
+        }
+    }
+
+    if( used == 0 )
+    {
+        zone->mean = zone->median;
+    }
+    else if( sum >= 0 )
+    {
+        zone->mean = (int16_t)( ( sum + used / 2 ) / used );
+    }
+    else
+    {
+        zone->mean = (int16_t)-( ( -sum + used / 2 ) / used );
+    }
+
+    return used;
+}
+
+void thermo8_statsReset(T_thermo8_stats *stats)
+{
+    stats->count = 0;
+    stats->meanR = 0;
+    stats->varQ  = 0;
+    stats->varR  = 0;
+}
+
+void thermo8_statsUpdate(T_thermo8_stats *stats, int16_t tRaw)
+{
+    uint32_t n;
+    int32_t  e;
+    int32_t  k;
+    int32_t  mOld;
+    int32_t  mNew;
+    int32_t  d1;
+    int32_t  d2;
+    uint32_t p;
+    uint32_t t;
+
+    if( stats->count == 0 )
+    {
+        stats->count = 1;
+        stats->tMin  = tRaw;
+        stats->tMax  = tRaw;
+        stats->meanQ = tRaw;
+        stats->meanR = 0;
+        stats->varQ  = 0;
+        stats->varR  = 0;
+        return;
+    }
+    if( tRaw < stats->tMin )
+    {
+        stats->tMin = tRaw;
+    }
+    if( tRaw > stats->tMax )
+    {
+        stats->tMax = tRaw;
+    }
+    if( stats->count >= THERMO8_STATS_MAX_COUNT )
+    {
+        return;
+    }
+
+    // sum' = meanQ * n + ( meanR + tRaw - meanQ )
+    mOld = _statsMeanQ4( stats );
+    n = stats->count + 1;
+    e = (int32_t)stats->meanR + tRaw - stats->meanQ;
+    if( e >= 0 )
+    {
+        k = e / (int32_t)n;
+    }
+    else
+    {
+        k = -( ( -e + (int32_t)n - 1 ) / (int32_t)n );
+    }
+    stats->meanQ += (int16_t)k;
+    stats->meanR  = (uint32_t)( e - k * (int32_t)n );
+    stats->count  = n;
+    mNew = _statsMeanQ4( stats );
+
+    // Welford step, both deltas carry the same sign
+    d1 = (int32_t)tRaw * 16 - mOld;
+    d2 = (int32_t)tRaw * 16 - mNew;
+    if( d1 < 0 )
+    {
+        d1 = -d1;
+        d2 = -d2;
+    }
+    if( d2 < 0 )
+    {
+        d2 = 0;
+    }
+    p = _mulSat( (uint32_t)d1, (uint32_t)d2 );
+
+    // M2' = varQ * n + ( varR + p - varQ )
+    if( p >= stats->varQ )
+    {
+        t = p - stats->varQ;
+        if( t > 0xFFFFFFFF - stats->varR )
+        {
+            t = 0xFFFFFFFF;
+        }
+        else
+        {
+            t += stats->varR;
+        }
+        stats->varQ += t / n;
+        stats->varR  = t % n;
+    }
+    else
+    {
+        t = stats->varQ - p;
+        if( t <= stats->varR )
+        {
+            stats->varR -= t;
+        }
+        else
+        {
+            t -= stats->varR;
+            k = (int32_t)( ( t + n - 1 ) / n );
+            stats->varQ -= (uint32_t)k;
+            stats->varR  = (uint32_t)k * n - t;
+        }
+    }
+}
+
+void thermo8_statsMerge(T_thermo8_stats *dst, const T_thermo8_stats *src)
+{
+    uint32_t n;
+    uint32_t t;
+    uint32_t rem;
+    uint32_t rem2;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t sq;
+    int32_t  d;
+    int32_t  e;
+    int32_t  mDst;
+    int32_t  mSrc;
+
+    if( src->count == 0 )
+    {
+        return;
+    }
+    if( dst->count == 0 )
+    {
+        *dst = *src;
+        return;
+    }
+    if( dst->count > THERMO8_STATS_MAX_COUNT - src->count )
+    {
+        return;
+    }
+
+    n = dst->count + src->count;
+    mDst = _statsMeanQ4( dst );
+    mSrc = _statsMeanQ4( src );
+
+    // M2 = M2a + M2b + delta^2 * na * nb / n, kept as quotient / remainder of n
+    d = mSrc - mDst;
+    if( d < 0 )
+    {
+        d = -d;
+    }
+    sq = _mulSat( (uint32_t)d, (uint32_t)d );
+    a = _mulDiv( dst->varQ, dst->count, n, &rem );
+    b = _mulDiv( src->varQ, src->count, n, &rem2 );
+    rem += rem2 + dst->varR + src->varR;
+    c = _mulDiv( _mulDiv( sq, dst->count, n, &rem2 ), src->count, n, &rem2 );
+    rem += rem2;
+    t = a + b;
+    if( t < a )
+    {
+        t = 0xFFFFFFFF;
+    }
+    if( t + c < t )
+    {
+        t = 0xFFFFFFFF;
+    }
+    else
+    {
+        t += c;
+    }
+    if( t + rem / n < t )
+    {
+        t = 0xFFFFFFFF;
+    }
+    else
+    {
+        t += rem / n;
+    }
+    dst->varQ = t;
+    dst->varR = rem % n;
+
+    // sum = meanQa * n + ( meanQb - meanQa ) * nb + meanRa + meanRb
+    d = (int32_t)src->meanQ - dst->meanQ;
+    if( d >= 0 )
+    {
+        t = _mulDiv( (uint32_t)d, src->count, n, &rem );
+        e = (int32_t)( dst->meanR + src->meanR + rem );
+        dst->meanQ += (int16_t)t;
+    }
+    else
+    {
+        t = _mulDiv( (uint32_t)-d, src->count, n, &rem );
+        e = (int32_t)( dst->meanR + src->meanR ) - (int32_t)rem;
+        dst->meanQ -= (int16_t)t;
+    }
+    while( e < 0 )
+    {
+        e += (int32_t)n;
+        dst->meanQ--;
+    }
+    while( e >= (int32_t)n )
+    {
+        e -= (int32_t)n;
+        dst->meanQ++;
+    }
+    dst->meanR = (uint32_t)e;
+
+    if( src->tMin < dst->tMin )
+    {
+        dst->tMin = src->tMin;
+    }
+    if( src->tMax > dst->tMax )
+    {
+        dst->tMax = src->tMax;
+    }
+    dst->count = n;
+}
+
+int32_t thermo8_statsMean(const T_thermo8_stats *stats)
+{
+    return _statsMeanQ4( stats );
+}
+
+uint32_t thermo8_statsVariance(const T_thermo8_stats *stats)
+{
+    return stats->varQ;
+}
+
+uint16_t thermo8_statsStddev(const T_thermo8_stats *stats)
+{
+    return _isqrt( stats->varQ );
+}
+
+void thermo8_predInit(T_thermo8_pred *pred, uint16_t periodMs, int16_t tUpper, int16_t tCrit)
+{
+    pred->head     = 0;
+    pred->n        = 0;
+    pred->sy       = 0;
+    pred->sxy      = 0;
+    // the slope is scaled by the period, 0 is taken as 1 ms
+    pred->periodMs = periodMs ? periodMs : 1;
+    pred->tUpper   = tUpper;
+    pred->tCrit    = tCrit;
+    pred->leadSec  = 0;
+    pred->fired    = 0;
+    pred->cb       = 0;
+}
+
+void thermo8_predLoadLimits(T_thermo8_pred *pred)
+{
+    pred->tUpper = _calFwd( _dev.slave, _rawToCode( thermo8_readReg(THERMO8_REG_TUPPER) ) );
+    pred->tCrit  = _calFwd( _dev.slave, _rawToCode( thermo8_readReg(THERMO8_REG_TCRIT) ) );
+}
+
+void thermo8_predSetCallback(T_thermo8_pred *pred, uint16_t leadSec, T_thermo8_predCb cb)
+{
+    pred->leadSec = leadSec;
+    pred->fired   = 0;
+    pred->cb      = cb;
+}
+
+void thermo8_predUpdate(T_thermo8_pred *pred, int16_t tRaw)
+{
+    uint16_t secs;
+
+    if( pred->n < THERMO8_PRED_LEN )
+    {
+        pred->sy  += tRaw;
+        pred->sxy += (int32_t)pred->n * tRaw;
+        pred->n++;
+    }
+    else
+    {
+        // drop the oldest ( x = 0 ) and shift the rest one step down
+        pred->sy  -= pred->buf[ pred->head ];
+        pred->sxy -= pred->sy;
+        pred->sxy += (int32_t)( THERMO8_PRED_LEN - 1 ) * tRaw;
+        pred->sy  += tRaw;
+    }
+    pred->buf[ pred->head ] = tRaw;
+    if( ++pred->head == THERMO8_PRED_LEN )
+    {
+        pred->head = 0;
+    }
+
+    if( pred->cb == 0 )
+    {
+        return;
+    }
+
+    secs = _predEval( pred, pred->tUpper );
+    if( secs < pred->leadSec )
+    {
+        if( !( pred->fired & 0x01 ) )
+        {
+            pred->fired |= 0x01;
+            pred->cb( THERMO8_REG_TUPPER, secs );
+        }
+    }
+    else
+    {
+        pred->fired &= ~0x01;
+    }
+
+    secs = _predEval( pred, pred->tCrit );
+    if( secs < pred->leadSec )
+    {
+        if( !( pred->fired & 0x02 ) )
+        {
+            pred->fired |= 0x02;
+            pred->cb( THERMO8_REG_TCRIT, secs );
+        }
+    }
+    else
+    {
+        pred->fired &= ~0x02;
+    }
+}
+
+uint16_t thermo8_predSeconds(T_thermo8_pred *pred, uint8_t limitRegaddr)
+{
+    if( limitRegaddr == THERMO8_REG_TCRIT )
+    {
+        return _predEval( pred, pred->tCrit );
+    }
+    return _predEval( pred, pred->tUpper );
+}
+
+uint8_t thermo8_discover()
+{
+    uint8_t i;
+
+    _inventory.present = 0;
+    for( i = 0; i < 8; i++ )
+    {
+        _inventory.revision[ i ] = 0;
+        _regCache[ i ].valid = 0;
+        if( _probe( THERMO8_ADDR_BASE + i, 1 ) )
+        {
+            _inventory.present |= 1 << i;
+        }
+    }
+
+    return _inventory.present;
+}
+
+uint8_t thermo8_rescan()
+{
+    uint8_t i;
+    uint8_t mask = 0;
+
+    for( i = 0; i < 8; i++ )
+    {
+        if( _probe( THERMO8_ADDR_BASE + i, !( _inventory.present & ( 1 << i ) ) ) )
+        {
+            mask |= 1 << i;
+        }
+    }
+    _inventory.present = mask;
+
+    return mask;
+}
+
+const T_thermo8_inventory* thermo8_getInventory()
+{
+    return &_inventory;
+}
+
+uint8_t thermo8_isPresent(uint8_t slave)
+{
+    if( ( slave < THERMO8_ADDR_BASE ) || ( slave > THERMO8_ADDR_LAST ) )
+    {
+        return 0;
+    }
+    return ( _inventory.present >> ( slave - THERMO8_ADDR_BASE ) ) & 0x01;
+}
+
+uint8_t thermo8_readAll(int16_t *tRaw)
+{
+    uint8_t i;
+    uint8_t mask = 0;
+    uint16_t tData;
+
+    for( i = 0; i < 8; i++ )
+    {
+        if( !( _inventory.present & ( 1 << i ) ) )
+        {
+            continue;
+        }
+        if( !_read16( THERMO8_ADDR_BASE + i, THERMO8_REG_TA, &tData ) )
+        {
+            tRaw[ i ] = _calFwd( THERMO8_ADDR_BASE + i, _rawToCode( tData ) );
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+}
+
+int thermo8_profileApply(const T_thermo8_profile *profile)
+{
+    int err;
+
+    if( ( _dev.slave < THERMO8_ADDR_BASE ) || ( _dev.slave > THERMO8_ADDR_LAST ) )
+    {
+        return 1;
+    }
+    err = _profileApply( _dev.slave, profile );
+    if( !_dev.err )
+    {
+        _dev.err = err;
+    }
+
+    return err;
+}
+
+uint8_t thermo8_profileApplyAll(const T_thermo8_profile *profile)
+{
+    uint8_t i;
+    uint8_t mask = 0;
+    int err;
+
+    for( i = 0; i < 8; i++ )
+    {
+        if( !( _inventory.present & ( 1 << i ) ) )
+        {
+            continue;
+        }
+        err = _profileApply( THERMO8_ADDR_BASE + i, profile );
+        if( err )
+        {
+            if( !_dev.err )
+            {
+                _dev.err = err;
+            }
+            continue;
+        }
+        mask |= 1 << i;
+    }
+
+    return mask;
+}
+
+void thermo8_cacheInvalidate()
+{
+    uint8_t i;
+
+    for( i = 0; i < 8; i++ )
+    {
+        _regCache[ i ].valid = 0;
+    }
+}
+
+uint8_t thermo8_warmBootCheck(const T_thermo8_profile *profile)
+{
+    uint16_t img[ 5 ];
+    uint16_t rData;
+    uint8_t  res;
+    uint8_t  i;
+
+    if( ( _dev.slave < THERMO8_ADDR_BASE ) || ( _dev.slave > THERMO8_ADDR_LAST ) )
+    {
+        return 0;
+    }
+    _profileImage( _dev.slave, profile, img );
+
+    if( _read16( _dev.slave, THERMO8_REG_CONFIG, &rData ) ||
+        ( ( rData ^ img[ 0 ] ) & _THERMO8_CFG_CMP_MASK ) )
+    {
+        return 0;
+    }
+    if( _read8( _dev.slave, THERMO8_REG_RESOLUTION, &res ) || ( res & 0x03 ) != img[ 4 ] )
+    {
+        return 0;
+    }
+    for( i = 1; i < 4; i++ )
+    {
+        if( _read16( _dev.slave, THERMO8_REG_CONFIG + i, &rData ) || ( rData != img[ i ] ) )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void thermo8_busLockSet(T_thermo8_lockFp lockFp, T_thermo8_lockFp unlockFp)
+{
+    _lockFp   = lockFp;
+    _unlockFp = unlockFp;
+}
+
+void thermo8_devInit(T_thermo8_dev *dev, uint8_t slave)
+{
+    dev->slave  = slave;
+    dev->status = 0;
+    dev->err    = 0;
+}
+
+uint16_t thermo8_devReadReg(T_thermo8_dev *dev, uint8_t rAddr)
+{
+    uint16_t rData = 0;
+    int err;
+
+    err = _read16( dev->slave, rAddr, &rData );
+    if( !dev->err )
+    {
+        dev->err = err;
+    }
+    return rData;
+}
+
+int thermo8_devWriteReg(T_thermo8_dev *dev, uint8_t rAddr, uint16_t rData)
+{
+    int err;
+
+    err = _write16( dev->slave, rAddr, rData );
+    if( !dev->err )
+    {
+        dev->err = err;
+    }
+    return err;
+}
+
+int16_t thermo8_devGetTemperatureRaw(T_thermo8_dev *dev)
+{
+    uint16_t tData;
+
+    tData = thermo8_devReadReg( dev, THERMO8_REG_TA );
+    dev->status = tData;
+    return _calFwd( dev->slave, _rawToCode( tData ) );
+}
+
+uint8_t thermo8_devGetAlertstat(T_thermo8_dev *dev)
+{
+    return _alertFlags( dev->status );
+}
+
+int thermo8_devGetError(T_thermo8_dev *dev)
+{
+    int err;
+
+    err = dev->err;
+    dev->err = 0;
+    return err;
+}
+
+int thermo8_getError()
+{
+    return thermo8_devGetError( &_dev );
+}
+
+void thermo8_retrySet(uint8_t retries)
+{
+    _retries = retries;
+}
+
+void thermo8_recoverSet(T_thermo8_recoverFp recoverFp)
+{
+    _recoverFp = recoverFp;
+}
+
+uint16_t thermo8_busRecover()
+{
+    uint16_t us = 0;
+
+#ifdef __THERMO8_BUS_SOFT__
+    us = _swRecover();
+#else
+    if( !_recoverFp )
+    {
+        return 0;
+    }
+    us = _recoverFp();
+#endif
+    _busStats.recoveries++;
+    _busStats.recoveryUs += us;
+    if( us > _busStats.recoveryUsMax )
+    {
+        _busStats.recoveryUsMax = us;
+    }
+
+    return us;
+}
+
+void thermo8_busStatsGet(T_thermo8_busStats *stats)
+{
+    *stats = _busStats;
+}
+
+void thermo8_busStatsReset()
+{
+    _busStats.errors        = 0;
+    _busStats.retries       = 0;
+    _busStats.failures      = 0;
+    _busStats.recoveries    = 0;
+    _busStats.recoveryUs    = 0;
+    _busStats.recoveryUsMax = 0;
+}
+
+void thermo8_asyncInit(T_thermo8_asyncStartFp startFp)
+{
+    _asyncHead    = 0;
+    _asyncCount   = 0;
+    _asyncStartFp = startFp;
+}
+
+uint8_t thermo8_asyncSubmit(T_thermo8_xfer *xfer)
+{
+    uint8_t idx;
+
+    THERMO8_ASYNC_ENTER();
+    if( _asyncCount == THERMO8_ASYNC_DEPTH )
+    {
+        THERMO8_ASYNC_EXIT();
+        return 1;
+    }
+    idx = _asyncHead + _asyncCount;
+    if( idx >= THERMO8_ASYNC_DEPTH )
+    {
+        idx -= THERMO8_ASYNC_DEPTH;
+    }
+    _asyncQueue[ idx ] = xfer;
+    _asyncCount++;
+    // idle queue, the HAL has to be kicked
+    if( ( _asyncCount == 1 ) && _asyncStartFp )
+    {
+        _asyncStartFp( xfer );
+    }
+    THERMO8_ASYNC_EXIT();
+
+    return 0;
+}
+
+void thermo8_asyncComplete(int err)
+{
+    T_thermo8_xfer *xfer;
+
+    if( _asyncCount == 0 )
+    {
+        return;
+    }
+    xfer = _asyncQueue[ _asyncHead ];
+    if( ++_asyncHead == THERMO8_ASYNC_DEPTH )
+    {
+        _asyncHead = 0;
+    }
+    _asyncCount--;
+
+    xfer->err = err;
+    if( !err )
+    {
+        _cacheStore( xfer->slave, xfer->rAddr, ( xfer->nBytes == 2 ) ?
+                     (uint16_t)xfer->buf[ 0 ] << 8 | xfer->buf[ 1 ] : xfer->buf[ 0 ] );
+    }
+    if( _asyncCount && _asyncStartFp )
+    {
+        _asyncStartFp( _asyncQueue[ _asyncHead ] );
+    }
+    if( xfer->cb )
+    {
+        xfer->cb( xfer );
+    }
+}
+
+uint8_t thermo8_asyncPoll()
+{
+    T_thermo8_xfer *xfer;
+    uint16_t rData;
+    int err;
+
+    if( _asyncStartFp || ( _asyncCount == 0 ) )
+    {
+        return _asyncCount;
+    }
+    xfer = _asyncQueue[ _asyncHead ];
+    if( xfer->write )
+    {
+        if( xfer->nBytes == 2 )
+        {
+            err = _write16( xfer->slave, xfer->rAddr,
+                            (uint16_t)xfer->buf[ 0 ] << 8 | xfer->buf[ 1 ] );
+        }
+        else
+        {
+            err = _write8( xfer->slave, xfer->rAddr, xfer->buf[ 0 ] );
+        }
+    }
+    else if( xfer->nBytes == 2 )
+    {
+        err = _read16( xfer->slave, xfer->rAddr, &rData );
+        if( !err )
+        {
+            xfer->buf[ 0 ] = (uint8_t)( rData >> 8 );
+            xfer->buf[ 1 ] = (uint8_t)rData;
+        }
+    }
+    else
+    {
+        err = _read8( xfer->slave, xfer->rAddr, &xfer->buf[ 0 ] );
+    }
+    THERMO8_ASYNC_ENTER();
+    thermo8_asyncComplete( err );
+    THERMO8_ASYNC_EXIT();
+
+    return _asyncCount;
+}
+
+uint8_t thermo8_asyncPending()
+{
+    return _asyncCount;
+}
+
+uint8_t thermo8_asyncScan(T_thermo8_xfer *xfers, T_thermo8_xferCb cb)
+{
+    uint8_t i;
+    uint8_t mask = 0;
+
+    for( i = 0; i < 8; i++ )
+    {
+        if( !( _inventory.present & ( 1 << i ) ) )
+        {
+            continue;
+        }
+        xfers[ i ].slave  = THERMO8_ADDR_BASE + i;
+        xfers[ i ].rAddr  = THERMO8_REG_TA;
+        xfers[ i ].nBytes = 2;
+        xfers[ i ].write  = 0;
+        xfers[ i ].err    = 0;
+        xfers[ i ].tag    = i;
+        xfers[ i ].cb     = cb;
+        if( thermo8_asyncSubmit( &xfers[ i ] ) )
+        {
+            break;
+        }
+        mask |= 1 << i;
+    }
+
+    return mask;
+}
+
+int16_t thermo8_xferTemperatureRaw(const T_thermo8_xfer *xfer)
+{
+    return _calFwd( xfer->slave, _rawToCode( (uint16_t)xfer->buf[ 0 ] << 8 | xfer->buf[ 1 ] ) );
+}
+
+void thermo8_taskInit(T_thermo8_task *task, uint8_t slave)
+{
+    thermo8_devInit( &task->dev, slave );
+    task->line     = 0;
+    task->op       = 0;
+    task->due      = 0;
+    task->tRaw     = 0;
+    task->xfer.tag = 0;
+}
+
+void thermo8_taskRun(T_thermo8_task *tasks, uint16_t n, T_thermo8_taskFp fn, uint32_t nowMs)
+{
+    uint16_t i;
+    uint16_t polls = 0;
+
+    _taskNow = nowMs;
+    for( i = 0; i < n; i++ )
+    {
+        // a full queue is served first, so the task does not have to back off
+        while( !_asyncStartFp && ( _asyncCount == THERMO8_ASYNC_DEPTH ) && ( polls < THERMO8_TASK_POLLS ) )
+        {
+            thermo8_asyncPoll();
+            polls++;
+        }
+        fn( &tasks[ i ] );
+    }
+    while( !_asyncStartFp && _asyncCount && ( polls < THERMO8_TASK_POLLS ) )
+    {
+        thermo8_asyncPoll();
+        polls++;
+    }
+}
+
+uint8_t thermo8_taskWake(T_thermo8_task *task)
+{
+    uint16_t cfg;
+
+    switch( task->op )
+    {
+        case 0 :
+            _taskSubmit( task, THERMO8_REG_CONFIG, 0, 0 );
+            task->op = 1;
+            return 0;
+        case 1 :
+            if( task->xfer.tag == 2 )
+            {
+                task->op = 0;
+            }
+            if( task->xfer.tag != 1 )
+            {
+                return 0;
+            }
+            if( task->xfer.err )
+            {
+                return _taskFail( task );
+            }
+            cfg = (uint16_t)task->xfer.buf[0] << 8 | task->xfer.buf[1];
+            _taskSubmit( task, THERMO8_REG_CONFIG, 1, cfg & ~THERMO8_CFG_SHDN );
+            task->op = 2;
+            return 0;
+        case 2 :
+            if( task->xfer.tag == 2 )
+            {
+                cfg = (uint16_t)task->xfer.buf[0] << 8 | task->xfer.buf[1];
+                _taskSubmit( task, THERMO8_REG_CONFIG, 1, cfg );
+            }
+            if( task->xfer.tag != 1 )
+            {
+                return 0;
+            }
+            if( task->xfer.err )
+            {
+                return _taskFail( task );
+            }
+            task->due = _taskNow + _convTime( task->dev.slave );
+            task->op = 3;
+            return 0;
+        default :
+            if( (int32_t)( _taskNow - task->due ) < 0 )
+            {
+                return 0;
+            }
+            task->op = 0;
+            return 1;
+    }
+}
+
+uint8_t thermo8_taskRead(T_thermo8_task *task)
+{
+    uint16_t tData;
+
+    if( task->op == 0 || task->xfer.tag == 2 )
+    {
+        _taskSubmit( task, THERMO8_REG_TA, 0, 0 );
+        task->op = 1;
+        return 0;
+    }
+    if( task->xfer.tag != 1 )
+    {
+        return 0;
+    }
+    if( task->xfer.err )
+    {
+        return _taskFail( task );
+    }
+    task->op = 0;
+    tData = (uint16_t)task->xfer.buf[0] << 8 | task->xfer.buf[1];
+    task->dev.status = tData;
+    task->tRaw = _calFwd( task->dev.slave, _rawToCode( tData ) );
+
+    return 1;
+}
+
+uint8_t thermo8_taskWaitAlert(T_thermo8_task *task)
+{
+    ( void )task;
+
+    // ALERT is active low with the driver defaults
+    return THERMO8_INT_GET() == 0;
+}
+
+uint8_t thermo8_taskDelay(T_thermo8_task *task, uint16_t ms)
+{
+    if( task->op == 0 )
+    {
+        task->due = _taskNow + ms;
+        task->op = 1;
+    }
+    if( (int32_t)( _taskNow - task->due ) < 0 )
+    {
+        return 0;
+    }
+    task->op = 0;
+
+    return 1;
+}
+
+void thermo8_ringInit(T_thermo8_ring *ring)
+{
+    ring->head    = 0;
+    ring->tail    = 0;
+    ring->dropped = 0;
+}
+
+uint8_t thermo8_ringPush(T_thermo8_ring *ring, const T_thermo8_sample *sample)
+{
+    uint8_t head = ring->head;
+
+    if( (uint8_t)( head - ring->tail ) >= THERMO8_RING_LEN )
+    {
+        ring->dropped++;
+        return 1;
+    }
+    ring->buf[ head & ( THERMO8_RING_LEN - 1 ) ] = *sample;
+    // publish after the slot is written
+    ring->head = head + 1;
+
+    return 0;
+}
+
+uint8_t thermo8_ringPop(T_thermo8_ring *ring, T_thermo8_sample *sample)
+{
+    uint8_t tail = ring->tail;
+
+    if( tail == ring->head )
+    {
+        return 0;
+    }
+    *sample = ring->buf[ tail & ( THERMO8_RING_LEN - 1 ) ];
+    ring->tail = tail + 1;
+
+    return 1;
+}
+
+uint8_t thermo8_plan(T_thermo8_plan *plan, uint32_t busHz, uint8_t nDev, uint8_t resolution, uint16_t periodMs)
+{
+    uint32_t busUs;
+    uint16_t busMs;
+
+    if( busHz == 0 )
+    {
+        busHz = 100000;
+    }
+    plan->readUs = (uint16_t)( ( 48000000UL + busHz - 1 ) / busHz );
+    plan->convMs = _convMs[ resolution & 0x03 ];
+
+    busUs = (uint32_t)nDev * plan->readUs;
+    busMs = (uint16_t)( ( busUs + 999 ) / 1000 );
+    plan->minPeriodMs = ( busMs > plan->convMs ) ? busMs : plan->convMs;
+    plan->rateMilliHz = 1000000UL / plan->minPeriodMs;
+
+    if( periodMs == 0 )
+    {
+        periodMs = plan->minPeriodMs;
+    }
+    busUs /= periodMs;
+    plan->loadPermil = ( busUs > 0xFFFF ) ? 0xFFFF : (uint16_t)busUs;
+
+    return periodMs < plan->minPeriodMs;
+}
+
+void thermo8_busHzSet(uint32_t busHz)
+{
+    _busHz = busHz ? busHz : THERMO8_BUS_HZ;
+}
+
+uint8_t thermo8_stagInit(T_thermo8_stag *stag, uint32_t nowMs)
+{
+    uint8_t n = 0;
+    uint8_t k = 0;
+    uint8_t i;
+
+    stag->present = _inventory.present;
+    stag->awake   = 0;
+    stag->fresh   = 0;
+    stag->convMs  = 0;
+    stag->base    = nowMs;
+    stag->errors  = 0;
+    for( i = 0; i < 8; i++ )
+    {
+        if( stag->present & ( 1 << i ) )
+        {
+            if( _convTime( THERMO8_ADDR_BASE + i ) > stag->convMs )
+            {
+                stag->convMs = _convTime( THERMO8_ADDR_BASE + i );
+            }
+            n++;
+        }
+    }
+    for( i = 0; i < 8; i++ )
+    {
+        stag->ageLast[ i ] = 0;
+        stag->ageMax[ i ]  = 0;
+        stag->slotMs[ i ]  = 0;
+        if( !( stag->present & ( 1 << i ) ) )
+        {
+            continue;
+        }
+        stag->slotMs[ i ] = (uint16_t)( (uint32_t)stag->convMs * k++ / n );
+        if( _shdnSet( THERMO8_ADDR_BASE + i, 1 ) )
+        {
+            stag->errors++;
+        }
+    }
+
+    return stag->present;
+}
+
+uint8_t thermo8_stagPoll(T_thermo8_stag *stag, uint32_t nowMs)
+{
+    uint16_t tData;
+    uint16_t age;
+    uint8_t  mask = 0;
+    uint8_t  bit;
+    uint8_t  i;
+
+    for( i = 0; i < 8; i++ )
+    {
+        bit = 1 << i;
+        if( !( stag->present & bit ) )
+        {
+            continue;
+        }
+        // the first conversion starts when the device leaves shutdown
+        if( !( stag->awake & bit ) )
+        {
+            if( (int32_t)( nowMs - stag->base - stag->slotMs[ i ] ) >= 0 )
+            {
+                if( _shdnSet( THERMO8_ADDR_BASE + i, 0 ) )
+                {
+                    stag->errors++;
+                    continue;
+                }
+                stag->awake    |= bit;
+                stag->wake[ i ] = nowMs;
+                stag->due[ i ]  = nowMs + stag->convMs + 1;
+            }
+            continue;
+        }
+        if( (int32_t)( nowMs - stag->due[ i ] ) < 0 )
+        {
+            continue;
+        }
+        do
+        {
+            stag->due[ i ] += stag->convMs;
+        }
+        while( (int32_t)( nowMs - stag->due[ i ] ) >= 0 );
+
+        if( _read16( THERMO8_ADDR_BASE + i, THERMO8_REG_TA, &tData ) )
+        {
+            stag->errors++;
+            continue;
+        }
+        age = (uint16_t)( ( nowMs - stag->wake[ i ] ) % stag->convMs );
+        stag->tRaw[ i ]    = _calFwd( THERMO8_ADDR_BASE + i, _rawToCode( tData ) );
+        stag->ageLast[ i ] = age;
+        if( age > stag->ageMax[ i ] )
+        {
+            stag->ageMax[ i ] = age;
+        }
+        mask |= bit;
+    }
+    stag->fresh = mask;
+
+    return mask;
+}
+
+int thermo8_muxSelect(uint8_t mux, uint8_t channel)
+{
+    int err;
+
+    _busLock();
+    err = _muxSelect( mux, channel );
+    _busUnlock();
+
+    return err;
+}
+
+int thermo8_muxRelease()
+{
+    int err;
+
+    _busLock();
+    err = _muxRelease();
+    _busUnlock();
+
+    return err;
+}
+
+int thermo8_muxReadReg(T_thermo8_muxDev *dev, uint8_t rAddr, uint16_t *rData)
+{
+    return _muxXfer( dev, rAddr, rData, 0, _retries );
+}
+
+int thermo8_muxWriteReg(T_thermo8_muxDev *dev, uint8_t rAddr, uint16_t rData)
+{
+    return _muxXfer( dev, rAddr, &rData, 1, _retries );
+}
+
+uint8_t thermo8_muxDiscover(uint8_t mux, T_thermo8_muxDev *list, uint8_t max)
+{
+    T_thermo8_muxDev dev;
+    uint16_t id;
+    uint8_t n = 0;
+    uint8_t c;
+    uint8_t a;
+
+    dev.mux = mux;
+    for( c = 0; c < 8; c++ )
+    {
+        dev.channel = c;
+        for( a = THERMO8_ADDR_BASE; ( a <= THERMO8_ADDR_LAST ) && ( n < max ); a++ )
+        {
+            dev.slave = a;
+            // single attempt, absent addresses are the normal case here
+            if( _muxXfer( &dev, THERMO8_REG_MANID, &id, 0, 0 ) || ( id != 0x0054 ) )
+            {
+                continue;
+            }
+            if( _muxXfer( &dev, THERMO8_REG_DEVID, &id, 0, 0 ) || ( ( id >> 8 ) != 0x04 ) )
+            {
+                continue;
+            }
+            list[ n++ ] = dev;
+        }
+    }
+
+    return n;
+}
+
+void thermo8_muxSort(T_thermo8_muxDev *list, uint8_t n)
+{
+    T_thermo8_muxDev tmp;
+    uint16_t key;
+    uint8_t i;
+    uint8_t j;
+
+    for( i = 1; i < n; i++ )
+    {
+        tmp = list[ i ];
+        key = _muxKey( &tmp );
+        for( j = i; j > 0; j-- )
+        {
+            if( _muxKey( &list[ j - 1 ] ) <= key )
+            {
+                break;
+            }
+            list[ j ] = list[ j - 1 ];
+        }
+        list[ j ] = tmp;
+    }
+}
+
+uint8_t thermo8_muxReadAll(T_thermo8_muxDev *list, uint8_t n, int16_t *tRaw)
+{
+    uint16_t tData;
+    uint8_t ok = 0;
+    uint8_t i;
+
+    for( i = 0; i < n; i++ )
+    {
+        if( !thermo8_muxReadReg( &list[ i ], THERMO8_REG_TA, &tData ) )
+        {
+            tRaw[ i ] = _rawToCode( tData );
+            ok++;
+        }
+    }
+
+    return ok;
+}
+
+void thermo8_demuxInit(T_thermo8_demux *demux)
+{
+    uint8_t i;
+
+    demux->fired = 0;
+    demux->reads = 0;
+    for( i = 0; i < 8; i++ )
+    {
+        demux->flags[ i ] = 0;
+        demux->hits[ i ]  = 0;
+    }
+}
+
+uint8_t thermo8_demuxAlert(T_thermo8_demux *demux)
+{
+    uint8_t  order[ 8 ];
+    uint16_t rank[ 8 ];
+    uint16_t cfg;
+    uint16_t tData;
+    uint8_t  slave;
+    uint8_t  fired = 0;
+    uint8_t  n = 0;
+    uint8_t  i;
+    uint8_t  j;
+    uint8_t  k;
+
+    // last offenders first, then by history, insertion sorted
+    for( i = 0; i < 8; i++ )
+    {
+        if( !( _inventory.present & ( 1 << i ) ) )
+        {
+            continue;
+        }
+        rank[ i ] = demux->hits[ i ];
+        if( demux->fired & ( 1 << i ) )
+        {
+            rank[ i ] += 0x100;
+        }
+        for( j = n; ( j > 0 ) && ( rank[ order[ j - 1 ] ] < rank[ i ] ); j-- )
+        {
+            order[ j ] = order[ j - 1 ];
+        }
+        order[ j ] = i;
+        n++;
+    }
+
+    demux->reads = 0;
+    for( k = 0; k < n; k++ )
+    {
+        // active low wired OR, released line reads high
+        if( THERMO8_INT_GET() )
+        {
+            break;
+        }
+        i = order[ k ];
+        slave = THERMO8_ADDR_BASE + i;
+        demux->reads++;
+        if( _read16( slave, THERMO8_REG_CONFIG, &cfg ) || !( cfg & THERMO8_CFG_ALERT_STAT ) )
+        {
+            continue;
+        }
+        fired |= 1 << i;
+        demux->reads++;
+        if( !_read16( slave, THERMO8_REG_TA, &tData ) )
+        {
+            demux->flags[ i ] = _alertFlags( tData );
+        }
+        if( demux->hits[ i ] == 0xFF )
+        {
+            for( j = 0; j < 8; j++ )
+            {
+                demux->hits[ j ] >>= 1;
+            }
+        }
+        demux->hits[ i ]++;
+        if( cfg & THERMO8_CFG_ALERT_MOD )
+        {
+            cfg &= _THERMO8_CFG_CMP_MASK;
+            if( !_write16( slave, THERMO8_REG_CONFIG, cfg | THERMO8_CFG_INT_CLEAR ) )
+            {
+                _cacheStore( slave, THERMO8_REG_CONFIG, cfg );
+            }
+        }
+    }
+    demux->fired = fired;
+
+    return fired;
+}
+
+uint8_t thermo8_acqInit(T_thermo8_acq *acq, uint16_t periodMs)
+{
+    T_thermo8_plan plan;
+    uint16_t conv = 0;
+    uint8_t nDev = 0;
+    uint8_t res = 0;
+    uint8_t i;
+
+    for( i = 0; i < 8; i++ )
+    {
+        if( ( _inventory.present & ( 1 << i ) ) &&
+            ( _convTime( THERMO8_ADDR_BASE + i ) >= conv ) )
+        {
+            conv = _convTime( THERMO8_ADDR_BASE + i );
+        }
+        nDev += ( _inventory.present >> i ) & 0x01;
+    }
+    while( ( res < 3 ) && ( _convMs[ res ] < conv ) )
+    {
+        res++;
+    }
+    if( periodMs == 0 )
+    {
+        periodMs = conv;
+    }
+    acq->nRings   = 0;
+    acq->latest   = 0;
+    acq->periodMs = periodMs;
+    acq->next     = 0;
+    acq->cycles   = 0;
+    acq->samples  = 0;
+    acq->errors   = 0;
+    acq->overruns = 0;
+    acq->lagLast  = 0;
+    acq->lagMax   = 0;
+
+    return thermo8_plan( &plan, _busHz, nDev, res, periodMs );
+}
+
+uint8_t thermo8_acqAddConsumer(T_thermo8_acq *acq, T_thermo8_ring *ring)
+{
+    if( acq->nRings == THERMO8_ACQ_CONSUMERS )
+    {
+        return 1;
+    }
+    acq->rings[ acq->nRings++ ] = ring;
+
+    return 0;
+}
+
+void thermo8_acqSetLatest(T_thermo8_acq *acq, T_thermo8_latest *latest)
+{
+    acq->latest = latest;
+}
+
+void thermo8_latestInit(T_thermo8_latest *latest)
+{
+    uint8_t i;
+
+    for( i = 0; i < 8; i++ )
+    {
+        latest->seq[ i ] = 0;
+    }
+}
+
+void thermo8_latestPublish(T_thermo8_latest *latest, const T_thermo8_sample *sample)
+{
+    uint8_t dev = sample->dev & 0x07;
+
+    latest->seq[ dev ]++;
+    latest->val[ dev ] = *sample;
+    latest->seq[ dev ]++;
+    // 0 is reserved for "never written"
+    if( latest->seq[ dev ] == 0 )
+    {
+        latest->seq[ dev ] = 2;
+    }
+}
+
+uint8_t thermo8_latestRead(T_thermo8_latest *latest, uint8_t dev, T_thermo8_sample *sample)
+{
+    uint16_t seq;
+    uint8_t  retry;
+
+    dev &= 0x07;
+    for( retry = 0; retry < 4; retry++ )
+    {
+        seq = latest->seq[ dev ];
+        if( seq == 0 )
+        {
+            return 0;
+        }
+        if( seq & 0x01 )
+        {
+            continue;
+        }
+        *sample = latest->val[ dev ];
+        if( latest->seq[ dev ] == seq )
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+uint8_t thermo8_acqPoll(T_thermo8_acq *acq, uint32_t nowMs)
+{
+    T_thermo8_sample sample;
+    uint16_t tData;
+    uint8_t  mask = 0;
+    uint8_t  i;
+    uint8_t  r;
+
+    if( acq->cycles == 0 && acq->next == 0 )
+    {
+        acq->next = nowMs;
+    }
+    if( (int32_t)( nowMs - acq->next ) < 0 )
+    {
+        return 0;
+    }
+
+    acq->lagLast = nowMs - acq->next;
+    if( acq->lagLast > acq->lagMax )
+    {
+        acq->lagMax = acq->lagLast;
+    }
+    acq->next += acq->periodMs;
+    while( acq->periodMs && (int32_t)( nowMs - acq->next ) >= 0 )
+    {
+        acq->next += acq->periodMs;
+        acq->overruns++;
+    }
+
+    sample.timeMs = nowMs;
+    for( i = 0; i < 8; i++ )
+    {
+        if( !( _inventory.present & ( 1 << i ) ) )
+        {
+            continue;
+        }
+        if( _read16( THERMO8_ADDR_BASE + i, THERMO8_REG_TA, &tData ) )
+        {
+            acq->errors++;
+            continue;
+        }
+        sample.tRaw  = _calFwd( THERMO8_ADDR_BASE + i, _rawToCode( tData ) );
+        sample.dev   = i;
+        sample.flags = _alertFlags( tData );
+        for( r = 0; r < acq->nRings; r++ )
+        {
+            thermo8_ringPush( acq->rings[ r ], &sample );
+        }
+        if( acq->latest )
+        {
+            thermo8_latestPublish( acq->latest, &sample );
+        }
+        acq->samples++;
+        mask |= 1 << i;
+    }
+    acq->cycles++;
+
+    return mask;
+}
+
+void thermo8_subInit(T_thermo8_sub *sub, uint8_t id, uint8_t devMask, uint16_t intervalMs, T_thermo8_frameFp out)
+{
+    sub->id         = id;
+    sub->devMask    = devMask;
+    sub->intervalMs = intervalMs;
+    sub->next       = 0;
+    sub->started    = 0;
+    sub->out        = out;
+}
+
+uint8_t thermo8_subServe(T_thermo8_sub *subs, uint8_t n, T_thermo8_latest *latest, uint32_t nowMs)
+{
+    T_thermo8_sample sample;
+    uint8_t frame[ THERMO8_FRAME_MAX ];
+    uint8_t sent = 0;
+    uint8_t len;
+    uint8_t sum;
+    uint8_t i;
+    uint8_t d;
+    uint8_t k;
+
+    for( i = 0; i < n; i++ )
+    {
+        if( subs[ i ].started && (int32_t)( nowMs - subs[ i ].next ) < 0 )
+        {
+            continue;
+        }
+        subs[ i ].started = 1;
+        subs[ i ].next = nowMs + subs[ i ].intervalMs;
+
+        frame[ 0 ] = 0xA5;
+        frame[ 1 ] = subs[ i ].id;
+        frame[ 3 ] = (uint8_t)( nowMs >> 24 );
+        frame[ 4 ] = (uint8_t)( nowMs >> 16 );
+        frame[ 5 ] = (uint8_t)( nowMs >> 8 );
+        frame[ 6 ] = (uint8_t)nowMs;
+        len = 7;
+        for( d = 0; d < 8; d++ )
+        {
+            if( ( subs[ i ].devMask & ( 1 << d ) ) && thermo8_latestRead( latest, d, &sample ) )
+            {
+                frame[ len++ ] = d;
+                frame[ len++ ] = sample.flags;
+                frame[ len++ ] = (uint8_t)( (uint16_t)sample.tRaw >> 8 );
+                frame[ len++ ] = (uint8_t)sample.tRaw;
+            }
+        }
+        if( len == 7 )
+        {
+            continue;
+        }
+        frame[ 2 ] = ( len - 7 ) / 4;
+        sum = 0;
+        for( k = 0; k < len; k++ )
+        {
+            sum += frame[ k ];
+        }
+        frame[ len++ ] = sum;
+
+        subs[ i ].out( frame, len );
+        sent++;
+    }
+
+    return sent;
+}
+
+void thermo8_decodeBatch(const uint16_t * _THERMO8_RESTRICT r, uint16_t n, int16_t * _THERMO8_RESTRICT c,
+                         float * _THERMO8_RESTRICT t, uint8_t * _THERMO8_RESTRICT f)
+{
+    uint16_t i;
+    uint16_t j;
+    uint8_t k;
+
+    // one branch free loop per output combination, scaling by 1/16 is exact
+    // in float so the product equals the _btoTconversion() quotient
+    switch( ( c ? 1 : 0 ) | ( t ? 2 : 0 ) | ( f ? 4 : 0 ) )
+    {
+        case 1 :
+            _THERMO8_BATCH( c[ j ] = _rawToCode( r[ j ] ) )
+            break;
+        case 2 :
+            _THERMO8_BATCH( t[ j ] = (float)_rawToCode( r[ j ] ) * 0.0625f )
+            break;
+        case 3 :
+            _THERMO8_BATCH( c[ j ] = _rawToCode( r[ j ] ); t[ j ] = (float)c[ j ] * 0.0625f )
+            break;
+        case 4 :
+            _THERMO8_BATCH( f[ j ] = _alertFlagsBits( r[ j ] ) )
+            break;
+        case 5 :
+            _THERMO8_BATCH( c[ j ] = _rawToCode( r[ j ] ); f[ j ] = _alertFlagsBits( r[ j ] ) )
+            break;
+        case 6 :
+            _THERMO8_BATCH( t[ j ] = (float)_rawToCode( r[ j ] ) * 0.0625f; f[ j ] = _alertFlagsBits( r[ j ] ) )
+            break;
+        case 7 :
+            _THERMO8_BATCH( c[ j ] = _rawToCode( r[ j ] ); t[ j ] = (float)c[ j ] * 0.0625f;
+                            f[ j ] = _alertFlagsBits( r[ j ] ) )
+            break;
+    }
+}
+
+void thermo8_seriesInit(T_thermo8_series *series, uint16_t n, int32_t *ewma, int16_t *tMin,
+                        int16_t *tMax, uint8_t *flags, uint8_t shift, int16_t tLower, int16_t tUpper)
+{
+    uint16_t i;
+
+    series->n      = n;
+    series->shift  = shift & 0x0F;
+    series->tLower = tLower;
+    series->tUpper = tUpper;
+    series->ewma   = ewma;
+    series->tMin   = tMin;
+    series->tMax   = tMax;
+    series->flags  = flags;
+    for( i = 0; i < n; i++ )
+    {
+        flags[ i ] = 0;
+    }
+}
+
+uint16_t thermo8_seriesUpdate(T_thermo8_series *series, const int16_t *code)
+{
+    int32_t  *ewma  = series->ewma;
+    int16_t  *tMin  = series->tMin;
+    int16_t  *tMax  = series->tMax;
+    uint8_t  *flags = series->flags;
+    uint8_t  shift  = series->shift;
+    int16_t  tLower = series->tLower;
+    int16_t  tUpper = series->tUpper;
+    uint16_t alerts = 0;
+    uint16_t i;
+    int32_t  x;
+    int16_t  c;
+    int16_t  v;
+    uint8_t  f;
+
+    for( i = 0; i < series->n; i++ )
+    {
+        c = code[ i ];
+        x = (int32_t)c << 8;
+        if( flags[ i ] & THERMO8_SER_VALID )
+        {
+            x = ewma[ i ] + ( ( x - ewma[ i ] ) >> shift );
+            if( c < tMin[ i ] )
+            {
+                tMin[ i ] = c;
+            }
+            if( c > tMax[ i ] )
+            {
+                tMax[ i ] = c;
+            }
+        }
+        else
+        {
+            tMin[ i ] = c;
+            tMax[ i ] = c;
+        }
+        ewma[ i ] = x;
+
+        v = (int16_t)( x >> 8 );
+        f = THERMO8_SER_VALID;
+        if( v < tLower )
+        {
+            f |= THERMO8_SER_LOWER;
+        }
+        if( v > tUpper )
+        {
+            f |= THERMO8_SER_UPPER;
+        }
+        flags[ i ] = f;
+        if( f != THERMO8_SER_VALID )
+        {
+            alerts++;
+        }
+    }
+
+    return alerts;
+}
+
+int16_t thermo8_seriesValue(const T_thermo8_series *series, uint16_t i)
+{
+    return (int16_t)( series->ewma[ i ] >> 8 );
+}
+
+static uint8_t *_putLe16(uint8_t *p, uint16_t v)
+{
+    p[ 0 ] = (uint8_t)v;
+    p[ 1 ] = (uint8_t)( v >> 8 );
+
+    return p + 2;
+}
+
+static uint8_t *_putLe32(uint8_t *p, uint32_t v)
+{
+    _putLe16( p, (uint16_t)v );
+
+    return _putLe16( p + 2, (uint16_t)( v >> 16 ) );
+}
+
+static uint16_t _getLe16(const uint8_t *p)
+{
+    return (uint16_t)p[ 1 ] << 8 | p[ 0 ];
+}
+
+static uint32_t _getLe32(const uint8_t *p)
+{
+    return (uint32_t)_getLe16( p + 2 ) << 16 | _getLe16( p );
+}
+
+void thermo8_archInit(T_thermo8_archive *arch, T_thermo8_archBlock *blocks, uint16_t nBlocks)
+{
+    arch->blocks  = blocks;
+    arch->nBlocks = nBlocks;
+    arch->used    = 0;
+}
+
+uint8_t thermo8_archAppend(T_thermo8_archive *arch, const T_thermo8_sample *sample)
+{
+    T_thermo8_archBlock *blk;
+    uint16_t i;
+
+    if( ( arch->used == 0 ) || ( arch->blocks[ arch->used - 1 ].count == THERMO8_ARCH_BLOCK ) )
+    {
+        if( arch->used == arch->nBlocks )
+        {
+            return 1;
+        }
+        blk = &arch->blocks[ arch->used++ ];
+        blk->count   = 0;
+        blk->codeMin = sample->tRaw;
+        blk->codeMax = sample->tRaw;
+        blk->timeMin = sample->timeMs;
+        blk->timeMax = sample->timeMs;
+    }
+    else
+    {
+        blk = &arch->blocks[ arch->used - 1 ];
+    }
+
+    i = blk->count;
+    blk->time[ i ]  = sample->timeMs;
+    blk->code[ i ]  = sample->tRaw;
+    blk->dev[ i ]   = sample->dev;
+    blk->flags[ i ] = sample->flags;
+    if( sample->tRaw < blk->codeMin )
+    {
+        blk->codeMin = sample->tRaw;
+    }
+    if( sample->tRaw > blk->codeMax )
+    {
+        blk->codeMax = sample->tRaw;
+    }
+    if( sample->timeMs < blk->timeMin )
+    {
+        blk->timeMin = sample->timeMs;
+    }
+    if( sample->timeMs > blk->timeMax )
+    {
+        blk->timeMax = sample->timeMs;
+    }
+    blk->count = i + 1;
+
+    return 0;
+}
+
+uint32_t thermo8_archScan(const T_thermo8_archive *arch, uint32_t t0, uint32_t t1,
+                          int16_t c0, int16_t c1, T_thermo8_archFp fn)
+{
+    const T_thermo8_archBlock *blk;
+    T_thermo8_sample sample;
+    uint32_t hits = 0;
+    uint16_t b;
+    uint16_t i;
+
+    for( b = 0; b < arch->used; b++ )
+    {
+        blk = &arch->blocks[ b ];
+        if( ( blk->timeMax < t0 ) || ( blk->timeMin > t1 ) ||
+            ( blk->codeMax < c0 ) || ( blk->codeMin > c1 ) )
+        {
+            continue;
+        }
+        for( i = 0; i < blk->count; i++ )
+        {
+            if( ( blk->time[ i ] < t0 ) || ( blk->time[ i ] > t1 ) ||
+                ( blk->code[ i ] < c0 ) || ( blk->code[ i ] > c1 ) )
+            {
+                continue;
+            }
+            hits++;
+            if( fn )
+            {
+                sample.timeMs = blk->time[ i ];
+                sample.tRaw   = blk->code[ i ];
+                sample.dev    = blk->dev[ i ];
+                sample.flags  = blk->flags[ i ];
+                fn( &sample );
+            }
+        }
+    }
+
+    return hits;
+}
+
+uint16_t thermo8_archBlockWrite(const T_thermo8_archBlock *blk, uint8_t *buf)
+{
+    uint8_t *p = buf;
+    uint16_t i;
+
+    *p++ = 'T';
+    *p++ = '8';
+    *p++ = 'A';
+    *p++ = 'B';
+    *p++ = _ARCH_VERSION;
+    *p++ = 0;
+    p = _putLe16( p, blk->count );
+    p = _putLe16( p, (uint16_t)blk->codeMin );
+    p = _putLe16( p, (uint16_t)blk->codeMax );
+    p = _putLe32( p, blk->timeMin );
+    p = _putLe32( p, blk->timeMax );
+    for( i = 0; i < blk->count; i++ )
+    {
+        p = _putLe32( p, blk->time[ i ] );
+    }
+    for( i = 0; i < blk->count; i++ )
+    {
+        p = _putLe16( p, (uint16_t)blk->code[ i ] );
+    }
+    for( i = 0; i < blk->count; i++ )
+    {
+        *p++ = blk->dev[ i ];
+    }
+    for( i = 0; i < blk->count; i++ )
+    {
+        *p++ = blk->flags[ i ];
+    }
+
+    return (uint16_t)( p - buf );
+}
+
+uint8_t thermo8_archBlockRead(T_thermo8_archBlock *blk, const uint8_t *buf, uint16_t len)
+{
+    const uint8_t *p;
+    uint16_t count;
+    uint16_t i;
+
+    if( ( len < 20 ) || ( buf[ 0 ] != 'T' ) || ( buf[ 1 ] != '8' ) || ( buf[ 2 ] != 'A' ) ||
+        ( buf[ 3 ] != 'B' ) || ( buf[ 4 ] != _ARCH_VERSION ) )
+    {
+        return 1;
+    }
+    count = _getLe16( buf + 6 );
+    if( ( count > THERMO8_ARCH_BLOCK ) || ( len < 20 + 8 * count ) )
+    {
+        return 1;
+    }
+    blk->count   = count;
+    blk->codeMin = (int16_t)_getLe16( buf + 8 );
+    blk->codeMax = (int16_t)_getLe16( buf + 10 );
+    blk->timeMin = _getLe32( buf + 12 );
+    blk->timeMax = _getLe32( buf + 16 );
+    p = buf + 20;
+    for( i = 0; i < count; i++, p += 4 )
+    {
+        blk->time[ i ] = _getLe32( p );
+    }
+    for( i = 0; i < count; i++, p += 2 )
+    {
+        blk->code[ i ] = (int16_t)_getLe16( p );
+    }
+    for( i = 0; i < count; i++ )
+    {
+        blk->dev[ i ] = *p++;
+    }
+    for( i = 0; i < count; i++ )
+    {
+        blk->flags[ i ] = *p++;
+    }
+
+    return 0;
+}
 
 /* -------------------------------------------------------------------------- */
 /*
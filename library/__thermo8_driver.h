@@ -51,6 +51,119 @@
    #define   __THERMO8_DRV_I2C__                            /**<     @macro __THERMO8_DRV_I2C__  @brief I2C driver selector */                                          
 // #define   __THERMO8_DRV_UART__                           /**<     @macro __THERMO8_DRV_UART__ @brief UART driver selector */ 
 
+// #define   __THERMO8_BUS_STATIC__                         /**<     @macro __THERMO8_BUS_STATIC__ @brief Compile time bus binding, see below */
+// #define   __THERMO8_BUS_SOFT__                           /**<     @macro __THERMO8_BUS_SOFT__ @brief Bit-banged I2C on the SCL / SDA pins, see below */
+
+#define   THERMO8_STATS_MAX_COUNT   0x1FFFFFFF                 /**<     @macro THERMO8_STATS_MAX_COUNT @brief Statistics window length limit */
+#define   THERMO8_PRED_LEN          8                          /**<     @macro THERMO8_PRED_LEN @brief Predictor regression window (2 - 16 samples) */
+#define   THERMO8_ASYNC_DEPTH       16                         /**<     @macro THERMO8_ASYNC_DEPTH @brief Asynchronous transaction queue length */
+#define   THERMO8_TASK_POLLS        64                         /**<     @macro THERMO8_TASK_POLLS @brief Queued transactions served per thermo8_taskRun() pass */
+#define   THERMO8_RING_LEN          16                         /**<     @macro THERMO8_RING_LEN @brief Sample queue length ( power of 2, max 128 ) */
+#define   THERMO8_ACQ_CONSUMERS     4                          /**<     @macro THERMO8_ACQ_CONSUMERS @brief Sample queues per acquisition */
+#define   THERMO8_FRAME_MAX         40                         /**<     @macro THERMO8_FRAME_MAX @brief Largest sample frame ( 8 devices ) */
+#define   THERMO8_ARCH_BLOCK        32                         /**<     @macro THERMO8_ARCH_BLOCK @brief Samples per archive block */
+#define   THERMO8_ARCH_IMAGE_MAX    ( 20 + 8 * THERMO8_ARCH_BLOCK ) /**< @macro THERMO8_ARCH_IMAGE_MAX @brief Largest serialized archive block, see thermo8_archBlockWrite() */
+#define   THERMO8_RETRY             1                          /**<     @macro THERMO8_RETRY @brief Default retries per register transaction */
+#define   THERMO8_BUS_HZ            100000                     /**<     @macro THERMO8_BUS_HZ @brief Default bus clock of the acquisition schedule check, see thermo8_busHzSet() */
+#define   THERMO8_SOFT_HALF_US      2                          /**<     @macro THERMO8_SOFT_HALF_US @brief Software I2C half bit time in us ( 2 - fast mode, 5 - standard mode ) */
+#define   THERMO8_SOFT_STRETCH      1000                       /**<     @macro THERMO8_SOFT_STRETCH @brief Software I2C clock stretching timeout in us */
+
+
+/**
+ * @note Compile time bus binding
+ *
+ * By default every register access is dispatched through the HAL function
+ * pointers filled by thermo8_i2cDriverInit(). With __THERMO8_BUS_STATIC__
+ * defined the driver calls the four macros below instead, so they can be
+ * bound directly to the platform library and the calls are resolved at
+ * compile time. The three bus macros return 0 on success, a failed start
+ * is retried like a NACK. Example for STM32 I2C1 :
+ *
+ * @code
+ * #define __THERMO8_BUS_STATIC__
+ * #define THERMO8_BUS_START()                     I2C1_Start()
+ * #define THERMO8_BUS_WRITE(addr, buf, n, mode)   I2C1_Write(addr, buf, n, mode)
+ * #define THERMO8_BUS_READ(addr, buf, n, mode)    I2C1_Read(addr, buf, n, mode)
+ * #define THERMO8_INT_GET()                       GPIOD_IDR.B10
+ * @endcode
+ */
+
+/**
+ * @note Software I2C
+ *
+ * With __THERMO8_BUS_SOFT__ defined the driver bit-bangs the bus on the
+ * mikroBUS SCL / SDA GPIO slots instead of using the I2C peripheral. Both
+ * pins have to be configured as open drain outputs with pull-ups, writing
+ * 1 releases the line and reading returns the line level. The slave may
+ * stretch the clock for up to THERMO8_SOFT_STRETCH us.
+ *
+ * Each SCL low and high phase lasts at least THERMO8_SOFT_HALF_US, the pin
+ * call overhead only adds to it. 2 meets the 1.3 us fast mode tLOW on any
+ * core, 5 the 4.7 us of standard mode. Slow cores run below the nominal
+ * rate, never above it.
+ */
+
+/**
+ * @note Asynchronous queue critical section
+ *
+ * When transactions are completed from interrupt context define
+ * THERMO8_ASYNC_ENTER() / THERMO8_ASYNC_EXIT() to mask the I2C ( or DMA )
+ * interrupt, e.g. DisableInterrupts() / EnableInterrupts(). They default
+ * to nothing for the polled backend.
+ */
+                                                                       /** @} */
+/** @defgroup THERMO8_REGMAP Register Map */                     /** @{ */
+
+#define   THERMO8_ADDR_BASE         0x18                       /**<     @macro THERMO8_ADDR_BASE @brief A2:A0 = 000 slave address */
+#define   THERMO8_ADDR_LAST         0x1F                       /**<     @macro THERMO8_ADDR_LAST @brief A2:A0 = 111 slave address */
+#define   THERMO8_MUX_BASE          0x70                       /**<     @macro THERMO8_MUX_BASE @brief TCA9548A base address ( 0x70 - 0x77 ) */
+
+#define   THERMO8_REG_CONFIG        0x01                       /**<     @macro THERMO8_REG_CONFIG @brief Configuration register */
+#define   THERMO8_REG_TUPPER        0x02                       /**<     @macro THERMO8_REG_TUPPER @brief Alert upper boundary */
+#define   THERMO8_REG_TLOWER        0x03                       /**<     @macro THERMO8_REG_TLOWER @brief Alert lower boundary */
+#define   THERMO8_REG_TCRIT         0x04                       /**<     @macro THERMO8_REG_TCRIT @brief Critical temperature */
+#define   THERMO8_REG_TA            0x05                       /**<     @macro THERMO8_REG_TA @brief Ambient temperature */
+#define   THERMO8_REG_MANID         0x06                       /**<     @macro THERMO8_REG_MANID @brief Manufacturer ID */
+#define   THERMO8_REG_DEVID         0x07                       /**<     @macro THERMO8_REG_DEVID @brief Device ID / revision */
+#define   THERMO8_REG_RESOLUTION    0x08                       /**<     @macro THERMO8_REG_RESOLUTION @brief Resolution ( 8 bit ) */
+
+/* CONFIG fields */
+#define   THERMO8_CFG_ALERT_MOD     0x0001                     /**<     @macro THERMO8_CFG_ALERT_MOD @brief 1 - interrupt, 0 - comparator output */
+#define   THERMO8_CFG_ALERT_POL     0x0002                     /**<     @macro THERMO8_CFG_ALERT_POL @brief 1 - active high ALERT */
+#define   THERMO8_CFG_ALERT_SEL     0x0004                     /**<     @macro THERMO8_CFG_ALERT_SEL @brief 1 - ALERT on TCRIT only */
+#define   THERMO8_CFG_ALERT_CNT     0x0008                     /**<     @macro THERMO8_CFG_ALERT_CNT @brief ALERT output enable */
+#define   THERMO8_CFG_ALERT_STAT    0x0010                     /**<     @macro THERMO8_CFG_ALERT_STAT @brief ALERT output status */
+#define   THERMO8_CFG_INT_CLEAR     0x0020                     /**<     @macro THERMO8_CFG_INT_CLEAR @brief Interrupt clear */
+#define   THERMO8_CFG_WIN_LOCK      0x0040                     /**<     @macro THERMO8_CFG_WIN_LOCK @brief TUPPER / TLOWER lock */
+#define   THERMO8_CFG_CRIT_LOCK     0x0080                     /**<     @macro THERMO8_CFG_CRIT_LOCK @brief TCRIT lock */
+#define   THERMO8_CFG_SHDN          0x0100                     /**<     @macro THERMO8_CFG_SHDN @brief Shutdown mode */
+#define   THERMO8_CFG_THYS(x)       ( (uint16_t)( (x) & 0x03 ) << 9 )  /**< @macro THERMO8_CFG_THYS @brief TUPPER / TLOWER hysteresis field */
+
+/* TA fields */
+#define   THERMO8_TA_CRIT           0x8000                     /**<     @macro THERMO8_TA_CRIT @brief TA >= TCRIT */
+#define   THERMO8_TA_UPPER          0x4000                     /**<     @macro THERMO8_TA_UPPER @brief TA > TUPPER */
+#define   THERMO8_TA_LOWER          0x2000                     /**<     @macro THERMO8_TA_LOWER @brief TA < TLOWER */
+#define   THERMO8_TA_SIGN           0x1000                     /**<     @macro THERMO8_TA_SIGN @brief Temperature sign */
+#define   THERMO8_TA_VALUE          0x0FFF                     /**<     @macro THERMO8_TA_VALUE @brief Temperature magnitude, 1/16 C */
+
+/* TUPPER / TLOWER / TCRIT field, q in 0.25 C steps ( two's complement ) */
+#define   THERMO8_LIMIT(q)          ( ( (uint16_t)(q) << 2 ) & 0x1FFC )  /**< @macro THERMO8_LIMIT @brief Limit register word */
+
+/* RESOLUTION field */
+#define   THERMO8_RES(x)            ( (uint8_t)(x) & 0x03 )    /**<     @macro THERMO8_RES @brief Resolution register byte */
+
+/**
+ * @note Register images built only from the macros above are constant
+ * expressions, e.g.
+ *
+ * @code
+ * thermo8_writeReg( THERMO8_REG_CONFIG, THERMO8_CFG_ALERT_MOD | THERMO8_CFG_ALERT_CNT |
+ *                                       THERMO8_CFG_THYS( 1 ) );
+ * thermo8_writeReg( THERMO8_REG_TUPPER, THERMO8_LIMIT( 28 * 4 ) );
+ * @endcode
+ *
+ * compiles to a single write with an immediate operand.
+ */
                                                                        /** @} */
 /** @defgroup THERMO8_VAR Variables */                           /** @{ */
 
@@ -87,10 +200,431 @@ const uint8_t THERMO8_R05C_30MS       ;
 const uint8_t THERMO8_R025C_65MS      ;
 const uint8_t THERMO8_R0125C_130MS    ;
 const uint8_t THERMO8_R00625C_250MS   ;
+
+const uint8_t THERMO8_LOCK_WIN        ;
+const uint8_t THERMO8_LOCK_CRIT       ;
+
+const int THERMO8_ERR_LOCKED          ;
+
+const uint8_t THERMO8_WIN_UPPER       ;
+const uint8_t THERMO8_WIN_LOWER       ;
+const uint8_t THERMO8_WIN_CRIT        ;
+
+const uint16_t THERMO8_PRED_NEVER     ;
+
+const uint8_t THERMO8_SER_LOWER       ;
+const uint8_t THERMO8_SER_UPPER       ;
+const uint8_t THERMO8_SER_VALID       ;
                                                                        /** @} */
 /** @defgroup THERMO8_TYPES Types */                             /** @{ */
 
+/**
+ * @struct T_thermo8_stats
+ * @brief Streaming statistics accumulator
+ *
+ * Integer Welford accumulator fed with raw TA codes. The mean is kept as an
+ * exact quotient / remainder pair over the sample count. M2 is stored the
+ * same way, but its Welford steps use means rounded down to 1/256 C, so
+ * the variance is accurate to that resolution only. Neither drifts nor
+ * overflows over long windows.
+ */
+typedef struct
+{
+    uint32_t    count;          /**< number of accumulated samples */
+    int16_t     tMin;           /**< minimum, 1/16 C */
+    int16_t     tMax;           /**< maximum, 1/16 C */
+    int16_t     meanQ;          /**< floor( sum / count ), 1/16 C */
+    uint32_t    meanR;          /**< sum - meanQ * count */
+    uint32_t    varQ;           /**< floor( M2 / count ), (1/256 C)^2 */
+    uint32_t    varR;           /**< M2 - varQ * count */
+
+}T_thermo8_stats;
+
+/**
+ * @brief Predictor callback, called with the limit register address
+ * (THERMO8_TUPPER / THERMO8_TCRIT) and the predicted seconds left.
+ */
+typedef void (*T_thermo8_predCb)(uint8_t, uint16_t);
+
+/**
+ * @struct T_thermo8_pred
+ * @brief Time-to-threshold predictor
+ *
+ * Least squares line over the last THERMO8_PRED_LEN samples. The running
+ * sums are slid in O(1) per sample.
+ */
+typedef struct
+{
+    int16_t             buf[ THERMO8_PRED_LEN ];
+    uint8_t             head;
+    uint8_t             n;
+    int32_t             sy;
+    int32_t             sxy;
+    uint16_t            periodMs;       /**< sample period */
+    int16_t             tUpper;         /**< TUPPER, 1/16 C */
+    int16_t             tCrit;          /**< TCRIT, 1/16 C */
+    uint16_t            leadSec;        /**< callback lead time */
+    uint8_t             fired;          /**< callbacks already issued */
+    T_thermo8_predCb    cb;
+
+}T_thermo8_pred;
+
+/**
+ * @struct T_thermo8_inventory
+ * @brief Devices found on the bus by thermo8_discover()
+ */
+typedef struct
+{
+    uint8_t     present;        /**< bit n set - device at THERMO8_ADDR0 + n answered */
+    uint8_t     revision[ 8 ];  /**< DEVID revision byte of each device */
+
+}T_thermo8_inventory;
+
+/**
+ * @struct T_thermo8_profile
+ * @brief Complete sensor configuration applied by thermo8_profileApply()
+ */
+typedef struct
+{
+    uint8_t     resolution;     /**< THERMO8_R05C_30MS ... THERMO8_R00625C_250MS */
+    int16_t     tUpper;         /**< TUPPER, 1/16 C ( rounded to 0.25 C ) */
+    int16_t     tLower;         /**< TLOWER, 1/16 C */
+    int16_t     tCrit;          /**< TCRIT, 1/16 C */
+    uint8_t     hysteresis;     /**< THERMO8_THYS_0C ... THERMO8_THYS_6C */
+    uint8_t     alertMode;      /**< THERMO8_TCRIT_ONLY_ALERT / THERMO8_ALERT_ON_ALL */
+    uint8_t     locks;          /**< THERMO8_LOCK_WIN | THERMO8_LOCK_CRIT */
+
+}T_thermo8_profile;
+
+/**
+ * @brief Bus lock hook, see thermo8_busLockSet()
+ */
+typedef void (*T_thermo8_lockFp)();
+
+/**
+ * @struct T_thermo8_dev
+ * @brief Per sensor driver state for the reentrant thermo8_dev* functions
+ */
+typedef struct
+{
+    uint8_t     slave;          /**< 7 bit slave address */
+    uint16_t    status;         /**< last TA word, holds the alert flags */
+    int         err;            /**< first error since thermo8_devGetError */
+
+}T_thermo8_dev;
+
+/**
+ * @struct T_thermo8_cal
+ * @brief Two point calibration, T = tRaw * gain / 16384 + offset
+ */
+typedef struct
+{
+    int16_t     offset;         /**< 1/16 C */
+    uint16_t    gain;           /**< Q14, 16384 = 1.0, 0 - not calibrated */
+
+}T_thermo8_cal;
+
+/**
+ * @struct T_thermo8_group
+ * @brief Redundant sensors watching one zone
+ */
+typedef struct
+{
+    uint8_t     n;              /**< members, 1 - 8 */
+    uint8_t     idx[ 8 ];       /**< member positions in the scan array */
+    uint8_t     k;              /**< outlier when | T - median | > k * MAD */
+    int16_t     madMin;         /**< lower bound of the MAD, 1/16 C */
+
+}T_thermo8_group;
+
+/**
+ * @struct T_thermo8_zone
+ * @brief Robust group value
+ */
+typedef struct
+{
+    int16_t     median;         /**< 1/16 C */
+    int16_t     mean;           /**< mean of the members not flagged, 1/16 C */
+    int16_t     mad;            /**< median absolute deviation, 1/16 C */
+    uint8_t     used;           /**< members with a valid reading */
+    uint8_t     outliers;       /**< bit i set - member i flagged */
+
+}T_thermo8_zone;
+
+/**
+ * @brief Bus recovery hook, returns the time spent in us
+ */
+typedef uint16_t (*T_thermo8_recoverFp)();
+
+/**
+ * @struct T_thermo8_busStats
+ * @brief Bus error instrumentation
+ */
+typedef struct
+{
+    uint32_t    errors;         /**< failed transaction attempts */
+    uint32_t    retries;        /**< attempts repeated after an error */
+    uint32_t    failures;       /**< calls failed after the retry budget */
+    uint32_t    recoveries;     /**< bus recoveries executed */
+    uint32_t    recoveryUs;     /**< total time spent recovering the bus */
+    uint16_t    recoveryUsMax;  /**< longest single recovery */
+
+}T_thermo8_busStats;
+
+/**
+ * @struct T_thermo8_xfer
+ * @brief Asynchronous register transaction descriptor
+ *
+ * Descriptors are owned by the caller and must stay valid until the
+ * completion callback has been called.
+ */
+typedef struct _thermo8_xfer
+{
+    uint8_t     slave;          /**< 7 bit slave address */
+    uint8_t     rAddr;          /**< register pointer */
+    uint8_t     nBytes;         /**< 1 or 2 data bytes */
+    uint8_t     write;          /**< 0 - read into buf, 1 - write buf */
+    uint8_t     buf[ 2 ];       /**< data, MSB first */
+    int         err;            /**< HAL result, 0 - no error */
+    uint8_t     tag;            /**< free for the application */
+    void        (*cb)(struct _thermo8_xfer *xfer);   /**< completion callback */
+
+}T_thermo8_xfer;
+
+/**
+ * @brief Completion callback of an asynchronous transaction
+ */
+typedef void (*T_thermo8_xferCb)(T_thermo8_xfer *xfer);
+
+/**
+ * @brief HAL hook which starts the transfer of a descriptor
+ */
+typedef void (*T_thermo8_asyncStartFp)(T_thermo8_xfer *xfer);
+
+/**
+ * @struct T_thermo8_task
+ * @brief Cooperative sensor task
+ *
+ * Stackless task state, see THERMO8_TASK_BEGIN(). Hundreds of tasks can be
+ * stepped from one loop, nothing is allocated per operation.
+ */
+typedef struct
+{
+    T_thermo8_dev   dev;        /**< sensor handle */
+    T_thermo8_xfer  xfer;       /**< in flight transaction */
+    uint16_t        line;       /**< resume point, THERMO8_TASK_STOPPED after a failure */
+    uint8_t         op;         /**< step of the pending operation */
+    uint32_t        due;        /**< timestamp the pending wait resolves at */
+    int16_t         tRaw;       /**< result of the last thermo8_taskRead() */
+
+}T_thermo8_task;
+
+/**
+ * @brief Task body, stepped by thermo8_taskRun()
+ */
+typedef void (*T_thermo8_taskFp)(T_thermo8_task *task);
+
+/**
+ * @struct T_thermo8_sample
+ * @brief Timestamped temperature sample
+ */
+typedef struct
+{
+    uint32_t    timeMs;         /**< acquisition time */
+    int16_t     tRaw;           /**< temperature, 1/16 C */
+    uint8_t     dev;            /**< device index, address - THERMO8_ADDR0 */
+    uint8_t     flags;          /**< thermo8_getAlertstat() style alert flags */
+
+}T_thermo8_sample;
+
+/**
+ * @struct T_thermo8_ring
+ * @brief Single producer / single consumer sample queue
+ *
+ * Lock free, the producer may run in interrupt context.
+ */
+typedef struct
+{
+    T_thermo8_sample    buf[ THERMO8_RING_LEN ];
+    volatile uint8_t    head;       /**< written by the producer only */
+    volatile uint8_t    tail;       /**< written by the consumer only */
+    uint32_t            dropped;    /**< samples lost on a full queue */
+
+}T_thermo8_ring;
+
+/**
+ * @struct T_thermo8_latest
+ * @brief Latest sample of every device, sequence lock protected
+ *
+ * Written by one acquisition, read by any number of readers without
+ * touching the bus or taking a lock. Both members are volatile so the
+ * compiler keeps the sample copy between the two sequence accesses.
+ */
+typedef struct
+{
+    volatile uint16_t           seq[ 8 ];   /**< odd while the entry is written */
+    volatile T_thermo8_sample   val[ 8 ];
+
+}T_thermo8_latest;
+
+/**
+ * @brief Frame transport, e.g. a UART write of len bytes
+ */
+typedef void (*T_thermo8_frameFp)(uint8_t *frame, uint16_t len);
+
+/**
+ * @struct T_thermo8_sub
+ * @brief Sample stream subscription
+ */
+typedef struct
+{
+    uint8_t             id;         /**< echoed in every frame */
+    uint8_t             devMask;    /**< subscribed devices, bit n is THERMO8_ADDR0 + n */
+    uint16_t            intervalMs; /**< minimum time between two frames */
+    uint32_t            next;       /**< next frame due */
+    uint8_t             started;
+    T_thermo8_frameFp   out;
+
+}T_thermo8_sub;
+
+/**
+ * @struct T_thermo8_archBlock
+ * @brief Archive block, fixed width columns with a min / max index
+ */
+typedef struct
+{
+    uint16_t    count;                          /**< samples in the block */
+    int16_t     codeMin;                        /**< index, lowest TA code */
+    int16_t     codeMax;                        /**< index, highest TA code */
+    uint32_t    timeMin;                        /**< index, oldest timestamp */
+    uint32_t    timeMax;                        /**< index, newest timestamp */
+    uint32_t    time[ THERMO8_ARCH_BLOCK ];     /**< column, timestamp in ms */
+    int16_t     code[ THERMO8_ARCH_BLOCK ];     /**< column, TA in 1/16 C */
+    uint8_t     dev[ THERMO8_ARCH_BLOCK ];      /**< column, device index */
+    uint8_t     flags[ THERMO8_ARCH_BLOCK ];    /**< column, alert flags */
+
+}T_thermo8_archBlock;
+
+/**
+ * @struct T_thermo8_archive
+ * @brief Append only sample archive over caller provided block storage
+ *
+ * The storage may be RAM, FRAM or memory mapped flash, blocks are only
+ * ever appended and can be read in place.
+ */
+typedef struct
+{
+    T_thermo8_archBlock     *blocks;
+    uint16_t                nBlocks;    /**< capacity */
+    uint16_t                used;       /**< blocks holding samples */
+
+}T_thermo8_archive;
+
+/**
+ * @brief Archive scan callback
+ */
+typedef void (*T_thermo8_archFp)(const T_thermo8_sample *sample);
+
+/**
+ * @struct T_thermo8_series
+ * @brief Filter state for many sensors, one array per field
+ *
+ * Arrays are provided by the caller and hold n entries each. The EWMA is
+ * kept in 1/4096 C ( code << 8 ) and uses alpha = 2^-shift.
+ */
+typedef struct
+{
+    uint16_t    n;
+    uint8_t     shift;
+    int16_t     tLower;                 /**< threshold, 1/16 C */
+    int16_t     tUpper;                 /**< threshold, 1/16 C */
+    int32_t     *ewma;
+    int16_t     *tMin;
+    int16_t     *tMax;
+    uint8_t     *flags;                 /**< THERMO8_SER_xxx */
+
+}T_thermo8_series;
+
+/**
+ * @struct T_thermo8_plan
+ * @brief Sample rate plan for one bus
+ */
+typedef struct
+{
+    uint16_t    readUs;         /**< bus time of one TA read */
+    uint16_t    convMs;         /**< conversion time at the resolution */
+    uint16_t    minPeriodMs;    /**< shortest period giving fresh samples of every device */
+    uint32_t    rateMilliHz;    /**< per device sample rate at minPeriodMs, 1/1000 Hz */
+    uint16_t    loadPermil;     /**< bus utilization at the requested period, 1/1000 */
+
+}T_thermo8_plan;
+
+/**
+ * @struct T_thermo8_stag
+ * @brief Staggered conversion schedule
+ */
+typedef struct
+{
+    uint8_t     present;        /**< scheduled devices */
+    uint8_t     awake;          /**< devices woken at their phase */
+    uint8_t     fresh;          /**< devices read since the last thermo8_stagPoll */
+    uint16_t    convMs;         /**< conversion period */
+    uint32_t    base;           /**< schedule start */
+    uint16_t    slotMs[ 8 ];    /**< read slot offset within the period */
+    uint32_t    wake[ 8 ];      /**< time the device was woken */
+    uint32_t    due[ 8 ];       /**< next read */
+    uint16_t    ageLast[ 8 ];   /**< sample age of the last read, ms */
+    uint16_t    ageMax[ 8 ];    /**< worst case sample age, ms */
+    int16_t     tRaw[ 8 ];      /**< last temperature, 1/16 C */
+    uint32_t    errors;
+
+}T_thermo8_stag;
+
+/**
+ * @struct T_thermo8_muxDev
+ * @brief Device behind a TCA9548A multiplexer
+ */
+typedef struct
+{
+    uint8_t     mux;            /**< multiplexer address, 0 - directly on the bus */
+    uint8_t     channel;        /**< multiplexer channel 0 - 7 */
+    uint8_t     slave;          /**< device address */
+    uint8_t     err;            /**< result of the last access */
+
+}T_thermo8_muxDev;
+
+/**
+ * @struct T_thermo8_demux
+ * @brief Shared ALERT line demultiplexer state
+ */
+typedef struct
+{
+    uint8_t     fired;          /**< devices found asserting ALERT by the last call */
+    uint8_t     reads;          /**< register reads used by the last call */
+    uint8_t     flags[ 8 ];     /**< last alert flags, THERMO8_xxx_REACHED */
+    uint8_t     hits[ 8 ];      /**< alert history used to order the queries */
+
+}T_thermo8_demux;
+
+/**
+ * @struct T_thermo8_acq
+ * @brief Bus acquisition cycle with throughput and lag metrics
+ */
+typedef struct
+{
+    T_thermo8_ring      *rings[ THERMO8_ACQ_CONSUMERS ];
+    uint8_t             nRings;
+    T_thermo8_latest    *latest;    /**< optional latest value table */
+    uint16_t            periodMs;   /**< cycle period */
+    uint32_t            next;       /**< next scheduled cycle */
+    uint32_t            cycles;     /**< completed cycles */
+    uint32_t            samples;    /**< published samples */
+    uint32_t            errors;     /**< failed device reads */
+    uint32_t            overruns;   /**< cycles skipped because of lag */
+    uint32_t            lagLast;    /**< ms the last cycle started late */
+    uint32_t            lagMax;     /**< worst lag seen */
 
+}T_thermo8_acq;
 
                                                                        /** @} */
 #ifdef __cplusplus
@@ -110,9 +644,9 @@ void thermo8_i2cDriverInit(T_THERMO8_P gpioObj, T_THERMO8_P i2cObj, uint8_t slav
 uint8_t thermo8_aleGet();
 
 /**
-   Generic function for writing to 16 bit registers.
+   Generic function for writing to 16 bit registers, returns 0 on success.
 */
-void thermo8_writeReg(uint8_t rAddr, uint16_t rData);
+int thermo8_writeReg(uint8_t rAddr, uint16_t rData);
 
 /**
    Generic function for reading from 16 bit registers.
@@ -120,9 +654,9 @@ void thermo8_writeReg(uint8_t rAddr, uint16_t rData);
 uint16_t thermo8_readReg(uint8_t rAddr);
 
 /**
-   Generic function for single byte writes.
+   Generic function for single byte writes, returns 0 on success.
 */
-void thermo8_writeReg8(uint8_t rAddr, uint8_t rData);
+int thermo8_writeReg8(uint8_t rAddr, uint8_t rData);
 
 /**
    Generic function for single byte read's.
@@ -163,13 +697,20 @@ uint16_t thermo8_getManid();
    Function will place Thermo 8 to the low power mode.
    To read the data from the sensor you will need to call the
    thermo8_wakeup() function.
+   
+   @return:
+       0 - no error, else the HAL error code, CONFIG is not written when
+       reading it failed
 */
-void thermo8_sleep();
+int thermo8_sleep();
 
 /**
    Function for waking up the click board from the sleep mode.
+   
+   @return:
+       0 - no error, else the HAL error code
 */
-void thermo8_wakeup();
+int thermo8_wakeup();
 
 /**
    Function for setting the temperature alarm levels for the
@@ -217,24 +758,997 @@ void thermo8_alertEnable(uint8_t thys, uint8_t alertCfg);
 /**
    Function for locking the critical temperature setting register.
    By default at powerup the register is unlocked.
+   
+   @return:
+       0 - no error, else the HAL error code, CONFIG is not written when
+       reading it failed
 */
-void thermo8_tcritLock();
+int thermo8_tcritLock();
 
 /**
    Function for unlocking the critical temperature setting register.
+   
+   @return:
+       0 - no error, else the HAL error code
 */
-void thermo8_tcritUnlock();
+int thermo8_tcritUnlock();
 
 /**
    Function for locking the Tupper and Tlower registers.
    By default at powerup the registers are unlocked.
+   
+   @return:
+       0 - no error, else the HAL error code, CONFIG is not written when
+       reading it failed
 */
-void thermo8_winLock();
+int thermo8_winLock();
 
 /**
    Function for unlocking the Tupper and Tlower registers.
+   
+   @return:
+       0 - no error, else the HAL error code
+*/
+int thermo8_winUnlock();
+
+/**
+   Function will return the raw temperature code in 1/16C steps
+   (sign extended 13 bit TA value). Alert flags are latched the same way
+   as with thermo8_getTemperatue().
+*/
+int16_t thermo8_getTemperatureRaw();
+
+                                                                       /** @} */
+/** @defgroup THERMO8_LIMITS Integer Limit Programming */        /** @{ */
+
+/**
+   Function for setting an alert limit in 0.25C steps, without float math.
+   
+   @params:
+       limitRegaddr - THERMO8_TUPPER, THERMO8_TLOWER or THERMO8_TCRIT
+       quarters     - limit in 0.25C, -1024 ( -256C ) ... 1023
+
+   @example:
+    -thermo8_limitSetQ2(THERMO8_TLOWER, -10 * 4 - 2); - limit to -10.5C
+*/
+void thermo8_limitSetQ2(uint8_t limitRegaddr, int16_t quarters);
+
+/**
+   Function for setting an alert limit in 1/16C steps. The value is rounded
+   to the nearest 0.25C limit step, ties away from zero as with
+   thermo8_limitSet().
+*/
+void thermo8_limitSetQ4(uint8_t limitRegaddr, int16_t tRaw);
+
+/**
+   Function for programming TUPPER, TLOWER and TCRIT together. All values
+   are in 1/16C and rounded to the nearest 0.25C, ties away from zero.
+   
+   Registers which already hold the target value ( cached or read back )
+   are not written. Every written register is read back for verification.
+   TUPPER / TLOWER are skipped when the window lock is set, TCRIT when the
+   critical lock is set.
+   
+   @return:
+       0 on success, otherwise a bit mask of registers which do not hold
+       the target value ( THERMO8_WIN_UPPER, THERMO8_WIN_LOWER, THERMO8_WIN_CRIT )
+*/
+uint8_t thermo8_windowSet(int16_t tUpper, int16_t tLower, int16_t tCrit);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_CAL Calibration */                         /** @{ */
+
+/**
+   Function for computing a calibration from two reference points.
+   
+   @params:
+       cal        - result
+       raw1, ref1 - sensor reading and reference at point 1, 1/16C
+       raw2, ref2 - sensor reading and reference at point 2, 1/16C
+       
+   @return:
+       0 - OK, 1 - points too close or gain out of range
+*/
+uint8_t thermo8_calFromPoints(T_thermo8_cal *cal, int16_t raw1, int16_t ref1, int16_t raw2, int16_t ref2);
+
+/**
+   Function for assigning a calibration to a device.
+   
+   @params:
+       slave - THERMO8_ADDR0 ... THERMO8_ADDR7
+       cal   - calibration, 0 - remove
+       
+   Temperatures returned by the driver for this device are corrected with
+   integer arithmetic, limits ( thermo8_limitSet*, thermo8_windowSet,
+   profiles ) are converted back, so alerts fire at calibrated
+   temperatures. Multiplexed devices are not covered, use
+   thermo8_calBatch on their scans.
+*/
+void thermo8_calSet(uint8_t slave, const T_thermo8_cal *cal);
+
+/**
+   Function for calibrating a bulk scan in place, code[ i ] is corrected
+   with cal[ i ].
+*/
+void thermo8_calBatch(const T_thermo8_cal *cal, int16_t *code, uint16_t n);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_DEV Reentrant Device Access */             /** @{ */
+
+/**
+   Function for installing the bus lock hooks. The lock is taken before the
+   start condition and released after the stop condition of every single
+   register transaction, so tasks sharing the bus interleave on
+   transaction boundaries only. Pass 0 for both to run without locking.
+   
+   Transfers started by a thermo8_asyncInit() HAL hook run in interrupt /
+   DMA context and do not take the lock. Do not mix them with blocking
+   calls from other tasks on the same bus.
+   
+   @example ( FreeRTOS ):
+    -void busLock()   { xSemaphoreTake( i2cMutex, portMAX_DELAY ); }
+    -void busUnlock() { xSemaphoreGive( i2cMutex ); }
+    -thermo8_busLockSet( busLock, busUnlock );
+*/
+void thermo8_busLockSet(T_thermo8_lockFp lockFp, T_thermo8_lockFp unlockFp);
+
+/**
+   Function for initializing a device handle. Each task owns its handles,
+   the functions below keep no other state between calls.
+*/
+void thermo8_devInit(T_thermo8_dev *dev, uint8_t slave);
+
+/**
+   Reentrant variant of thermo8_readReg().
+*/
+uint16_t thermo8_devReadReg(T_thermo8_dev *dev, uint8_t rAddr);
+
+/**
+   Reentrant variant of thermo8_writeReg().
+*/
+int thermo8_devWriteReg(T_thermo8_dev *dev, uint8_t rAddr, uint16_t rData);
+
+/**
+   Reentrant variant of thermo8_getTemperatureRaw(), the alert flags are
+   latched in the handle.
+*/
+int16_t thermo8_devGetTemperatureRaw(T_thermo8_dev *dev);
+
+/**
+   Reentrant variant of thermo8_getAlertstat().
+*/
+uint8_t thermo8_devGetAlertstat(T_thermo8_dev *dev);
+
+/**
+   Reentrant variant of thermo8_getError().
+*/
+int thermo8_devGetError(T_thermo8_dev *dev);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_ERR Bus Error Handling */                  /** @{ */
+
+/**
+   Function for reading the first bus error since the previous call.
+   
+   @return:
+       0 - every register access succeeded, else the HAL error code
+       
+   Covers all functions without a device argument, values they returned
+   after an error are 0.
+*/
+int thermo8_getError();
+
+/**
+   Function for setting the retry budget of each register transaction.
+   
+   A failed attempt is followed by a bus recovery and a new attempt, so a
+   call takes at most retries + 1 attempts and retries recoveries. Device
+   discovery always uses a single attempt.
+*/
+void thermo8_retrySet(uint8_t retries);
+
+/**
+   Function for installing the bus recovery of a hardware I2C peripheral.
+   
+   The hook has to clock SCL nine times, generate a STOP and return the
+   time it took in us. The software I2C backend ( __THERMO8_BUS_SOFT__ )
+   recovers the bus itself in at most 21 half bit times.
+*/
+void thermo8_recoverSet(T_thermo8_recoverFp recoverFp);
+
+/**
+   Function for recovering the bus now.
+   
+   @return:
+       time spent in us, 0 - no recovery available
+*/
+uint16_t thermo8_busRecover();
+
+/**
+   Function for copying the bus error counters.
+*/
+void thermo8_busStatsGet(T_thermo8_busStats *stats);
+
+/**
+   Function for clearing the bus error counters.
+*/
+void thermo8_busStatsReset();
+
+                                                                       /** @} */
+/** @defgroup THERMO8_ASYNC Asynchronous Transactions */         /** @{ */
+
+/**
+   Function for initializing the asynchronous transaction queue.
+   
+   @params:
+       startFp - HAL hook which starts an interrupt / DMA driven transfer of
+                 the descriptor and calls thermo8_asyncComplete() once it
+                 has finished. With 0 the queue is served by
+                 thermo8_asyncPoll() using blocking transfers.
+                 
+   Hook driven transfers bypass the thermo8_busLockSet() lock, the hook
+   and the blocking functions must not share a bus. The polled backend
+   takes the lock for each transfer.
+*/
+void thermo8_asyncInit(T_thermo8_asyncStartFp startFp);
+
+/**
+   Function for queueing a transaction descriptor.
+   
+   @return:
+       0 - queued, 1 - queue full
+*/
+uint8_t thermo8_asyncSubmit(T_thermo8_xfer *xfer);
+
+/**
+   Function to be called by the HAL ( interrupt / DMA context ) when the
+   transfer of the head descriptor has finished. The descriptor callback
+   is called and the next queued transfer is started.
+*/
+void thermo8_asyncComplete(int err);
+
+/**
+   Polled backend, runs the head descriptor with a blocking transfer and
+   completes it. Does nothing when a HAL start hook is installed.
+   
+   @return:
+       number of descriptors still queued
+*/
+uint8_t thermo8_asyncPoll();
+
+/**
+   Function will return the number of queued descriptors.
+*/
+uint8_t thermo8_asyncPending();
+
+/**
+   Function will queue a TA read for every device in the cached inventory.
+   
+   @params:
+       xfers - array of 8 descriptors, indexed by address - THERMO8_ADDR0
+       cb    - completion callback for every read
+       
+   @return:
+       bit mask of queued reads
+*/
+uint8_t thermo8_asyncScan(T_thermo8_xfer *xfers, T_thermo8_xferCb cb);
+
+/**
+   Function will return the temperature in 1/16C from a completed TA read.
+*/
+int16_t thermo8_xferTemperatureRaw(const T_thermo8_xfer *xfer);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_TASK Cooperative Sensor Tasks */           /** @{ */
+
+/**
+ * @macro THERMO8_TASK_BEGIN
+ * @brief Task body helpers
+ *
+ * A task body is a plain function which resumes where it last waited.
+ * Local variables do not survive a wait, keep state in the task, and
+ * use at most one THERMO8_TASK_AWAIT() per source line.
+ *
+ * An awaitable returns 0 while pending, 1 when done and 2 when its bus
+ * transaction failed. A failure stops the task: task->line reads
+ * THERMO8_TASK_STOPPED, thermo8_devGetError( &task->dev ) returns the
+ * HAL error and thermo8_taskInit() starts the task over.
+ *
+ * @code
+ * void sensorTask(T_thermo8_task *t)
+ * {
+ *     THERMO8_TASK_BEGIN( t );
+ *     THERMO8_TASK_AWAIT( t, thermo8_taskWake( t ) );
+ *     for( ;; )
+ *     {
+ *         THERMO8_TASK_AWAIT( t, thermo8_taskRead( t ) );
+ *         // t->tRaw holds the temperature
+ *         THERMO8_TASK_AWAIT( t, thermo8_taskDelay( t, 1000 ) );
+ *     }
+ *     THERMO8_TASK_END( t );
+ * }
+ * @endcode
+ */
+#define THERMO8_TASK_STOPPED        0xFFFF
+#define THERMO8_TASK_BEGIN(t)       switch( (t)->line ) { case 0:
+#define THERMO8_TASK_AWAIT(t, c)    (t)->line = __LINE__; case __LINE__: switch( c ) { case 0: return; \
+                                    case 1: break; default: (t)->line = THERMO8_TASK_STOPPED; return; }
+#define THERMO8_TASK_END(t)         } if( (t)->line != THERMO8_TASK_STOPPED ) (t)->line = 0
+
+/**
+   Function for initializing a task for the sensor at the given address.
+*/
+void thermo8_taskInit(T_thermo8_task *task, uint8_t slave);
+
+/**
+   Function will step every task once and serve the asynchronous queue.
+   Needs thermo8_asyncInit() to be called first.
+   
+   @note Without a HAL start hook the queue is served here with blocking
+   transfers : whenever it fills up during the pass and once more after
+   the last task, until it is idle or THERMO8_TASK_POLLS transactions
+   were served in this pass.
+   
+   @params:
+       tasks - task array
+       n     - number of tasks
+       fn    - task body
+       nowMs - current time in milliseconds
+*/
+void thermo8_taskRun(T_thermo8_task *tasks, uint16_t n, T_thermo8_taskFp fn, uint32_t nowMs);
+
+/**
+   Awaitable, leaves shutdown mode and resolves once the first conversion
+   at the current resolution ( 30 - 250 ms ) is done. CONFIG is only
+   written back after it was read successfully.
+*/
+uint8_t thermo8_taskWake(T_thermo8_task *task);
+
+/**
+   Awaitable, reads TA into task->tRaw and latches the alert flags in
+   task->dev. Both are left unchanged by a failed read.
+*/
+uint8_t thermo8_taskRead(T_thermo8_task *task);
+
+/**
+   Awaitable, resolves while the ALERT ( INT pin ) line is asserted.
+*/
+uint8_t thermo8_taskWaitAlert(T_thermo8_task *task);
+
+/**
+   Awaitable, resolves after ms milliseconds.
+*/
+uint8_t thermo8_taskDelay(T_thermo8_task *task, uint16_t ms);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_ACQ Acquisition and Sample Queues */       /** @{ */
+
+/**
+   Function for clearing a sample queue.
+*/
+void thermo8_ringInit(T_thermo8_ring *ring);
+
+/**
+   Function for adding a sample, producer side. On a full queue the
+   sample is dropped and counted.
+   
+   @return:
+       0 - queued, 1 - dropped
+*/
+uint8_t thermo8_ringPush(T_thermo8_ring *ring, const T_thermo8_sample *sample);
+
+/**
+   Function for taking the oldest sample, consumer side.
+   
+   @return:
+       1 - sample copied, 0 - queue empty
+*/
+uint8_t thermo8_ringPop(T_thermo8_ring *ring, T_thermo8_sample *sample);
+
+/**
+   Function for initializing the acquisition.
+   
+   @params:
+       acq      - acquisition
+       periodMs - cycle period, 0 - the conversion time of the slowest
+                  device in the cached inventory
+                  
+   @return:
+       0 - schedule fits, 1 - periodMs is shorter than thermo8_plan allows
+       for the inventory at the thermo8_busHzSet() clock
+*/
+uint8_t thermo8_acqInit(T_thermo8_acq *acq, uint16_t periodMs);
+
+/**
+   Function for attaching a consumer queue, every sample is published to
+   all attached queues.
+   
+   @return:
+       0 - attached, 1 - THERMO8_ACQ_CONSUMERS reached
+*/
+uint8_t thermo8_acqAddConsumer(T_thermo8_acq *acq, T_thermo8_ring *ring);
+
+/**
+   Function for attaching a latest value table, every cycle updates it.
+*/
+void thermo8_acqSetLatest(T_thermo8_acq *acq, T_thermo8_latest *latest);
+
+/**
+   Function for clearing the latest value table.
+*/
+void thermo8_latestInit(T_thermo8_latest *latest);
+
+/**
+   Function for storing a sample, writer side ( single writer ).
+*/
+void thermo8_latestPublish(T_thermo8_latest *latest, const T_thermo8_sample *sample);
+
+/**
+   Function for reading the latest sample of a device, reader side.
+   The copy is retried while the writer updates the entry. A reader which
+   interrupts the writer gives up after a few retries.
+   
+   @params:
+       latest - table
+       dev    - device index, address - THERMO8_ADDR0
+       sample - copy of the latest sample
+       
+   @return:
+       1 - consistent sample copied, 0 - no sample yet or entry busy
+*/
+uint8_t thermo8_latestRead(T_thermo8_latest *latest, uint8_t dev, T_thermo8_sample *sample);
+
+/**
+   Function will run a cycle over the cached inventory once it is due and
+   publish the samples. Call it from the main loop or a timer interrupt.
+   When the cycle falls more than one period behind the missed cycles are
+   skipped and counted as overruns.
+   
+   @return:
+       bit mask of devices read, 0 when no cycle was due
+*/
+uint8_t thermo8_acqPoll(T_thermo8_acq *acq, uint32_t nowMs);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_PLAN Bus Planning */                       /** @{ */
+
+/**
+   Function for planning the sample rate of devices sharing one bus.
+   
+   @params:
+       plan       - result
+       busHz      - I2C clock, e.g. 100000 or 400000
+       nDev       - devices read every cycle
+       resolution - resolution register value ( 0 - 3 )
+       periodMs   - requested cycle period, 0 - use the planned minimum
+       
+   @return:
+       0 - schedule fits, 1 - periodMs is shorter than minPeriodMs
+       
+   A TA read takes 48 bit times ( pointer write, restart, 2 byte read ).
+   The per device rate is limited by the conversion time and by the bus
+   time of reading all nDev devices.
+*/
+uint8_t thermo8_plan(T_thermo8_plan *plan, uint32_t busHz, uint8_t nDev, uint8_t resolution, uint16_t periodMs);
+
+/**
+   Function for setting the I2C clock the bus actually runs at, used by
+   the schedule check of thermo8_acqInit(). Defaults to THERMO8_BUS_HZ,
+   0 restores the default.
+*/
+void thermo8_busHzSet(uint32_t busHz);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_STAG Staggered Conversions */               /** @{ */
+
+/**
+   Function for starting a staggered schedule over the cached inventory.
+   
+   @params:
+       stag  - schedule
+       nowMs - current time
+       
+   @return:
+       scheduled devices
+       
+   All devices are put in shutdown and woken one by one, evenly spaced
+   over the conversion period, so their conversions and reads do not
+   coincide. Devices with a locked configuration can not be shut down and
+   keep their own phase. The device oscillators drift slowly, call again
+   every few minutes to realign the phases.
+*/
+uint8_t thermo8_stagInit(T_thermo8_stag *stag, uint32_t nowMs);
+
+/**
+   Function for running the staggered schedule, call at least every 1 ms.
+   
+   @return:
+       devices read by this call, samples are in stag->tRaw
+*/
+uint8_t thermo8_stagPoll(T_thermo8_stag *stag, uint32_t nowMs);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_MUX I2C Multiplexer */                     /** @{ */
+
+/**
+   Function for selecting a multiplexer channel.
+   
+   @params:
+       mux     - TCA9548A address
+       channel - 0 - 7, any other value disconnects all channels
+       
+   @return:
+       0 - OK, else the HAL error code of the first failed multiplexer
+       write, nothing is selected after a failed disconnect
+       
+   The selection is cached, nothing is written when the channel is already
+   selected. Channels of other multiplexers selected earlier are
+   disconnected first, so equal device addresses never meet on the bus.
+   While a channel is selected the register cache is bypassed.
+   
+   The guarantee only covers the thermo8_mux* functions. The other
+   register functions address the bus as it is, call thermo8_muxRelease()
+   before using them on devices wired directly to the bus.
+*/
+int thermo8_muxSelect(uint8_t mux, uint8_t channel);
+
+/**
+   Function for disconnecting every channel selected through the driver.
+   
+   @return:
+       0 - OK, else the first HAL error code, the remaining multiplexers
+       are still disconnected
+*/
+int thermo8_muxRelease();
+
+/**
+   Function for reading a register of a multiplexed device. The bus lock
+   is held from the channel selection to the end of the transaction.
+   
+   @return:
+       0 - OK
+*/
+int thermo8_muxReadReg(T_thermo8_muxDev *dev, uint8_t rAddr, uint16_t *rData);
+
+/**
+   Function for writing a register of a multiplexed device, locked like
+   thermo8_muxReadReg().
+   
+   @return:
+       0 - OK
+*/
+int thermo8_muxWriteReg(T_thermo8_muxDev *dev, uint8_t rAddr, uint16_t rData);
+
+/**
+   Function for finding devices on all channels of one multiplexer.
+   
+   @params:
+       mux  - TCA9548A address
+       list - output, sorted by channel
+       max  - list size
+       
+   @return:
+       number of devices found
+*/
+uint8_t thermo8_muxDiscover(uint8_t mux, T_thermo8_muxDev *list, uint8_t max);
+
+/**
+   Function for ordering a device list by multiplexer and channel.
+*/
+void thermo8_muxSort(T_thermo8_muxDev *list, uint8_t n);
+
+/**
+   Function for reading the temperature of every device in the list.
+   
+   @params:
+       list - devices, sorted with thermo8_muxSort
+       n    - list length
+       tRaw - output, TA in 1/16C per list entry
+       
+   @return:
+       number of devices read, failures are marked in list[ i ].err
+       
+   With a sorted list every channel is selected once per scan.
+*/
+uint8_t thermo8_muxReadAll(T_thermo8_muxDev *list, uint8_t n, int16_t *tRaw);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_DEMUX Shared Alert Line */                 /** @{ */
+
+/**
+   Function for initializing the alert demultiplexer.
+*/
+void thermo8_demuxInit(T_thermo8_demux *demux);
+
+/**
+   Function for finding the devices driving a shared ALERT line.
+   
+   @params:
+       demux - state kept between calls
+       
+   @return:
+       devices with ALERT asserted
+       
+   Devices of the cached inventory are queried ( CONFIG alert status )
+   starting with the ones that fired last time and then by alert history.
+   Devices in interrupt mode are cleared as they are found and the search
+   stops as soon as the INT pin deasserts. The alert flags of every device
+   found are stored in demux->flags. ALERT outputs must be open drain,
+   active low, for the wired OR.
+*/
+uint8_t thermo8_demuxAlert(T_thermo8_demux *demux);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_SUB Sample Stream Service */               /** @{ */
+
+/**
+   Function for initializing a subscription.
+   
+   Frame layout ( multi byte fields MSB first ) :
+   
+   | Bytes | Field                                   |
+   |:-----:|:----------------------------------------|
+   | 1     | 0xA5 sync                               |
+   | 1     | subscription id                         |
+   | 1     | n - number of samples                   |
+   | 4     | time of the frame in ms                 |
+   | 4 * n | device index, alert flags, 1/16 C TA   |
+   | 1     | sum of all previous bytes, modulo 256   |
+*/
+void thermo8_subInit(T_thermo8_sub *sub, uint8_t id, uint8_t devMask, uint16_t intervalMs, T_thermo8_frameFp out);
+
+/**
+   Function will send one batched frame to every subscription which is due.
+   Samples are taken from the latest value table, so the number of
+   subscriptions does not add bus traffic.
+   
+   @return:
+       number of frames sent
+*/
+uint8_t thermo8_subServe(T_thermo8_sub *subs, uint8_t n, T_thermo8_latest *latest, uint32_t nowMs);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_DECODE Batch Decoding */                   /** @{ */
+
+/**
+   Function for decoding an array of raw TA register words.
+   
+   @params:
+       raw   - TA words as read from the device
+       n     - number of words
+       code  - output, temperature in 1/16C, may be 0
+       temp  - output, temperature in C, may be 0
+       flags - output, alert flags ( same bits as thermo8_getAlertstat ), may be 0
+       
+   Results match _btoTconversion and thermo8_getAlertstat for every word.
+   The output arrays must not overlap each other or raw, the loops are
+   compiled on that assumption.
+*/
+void thermo8_decodeBatch(const uint16_t *raw, uint16_t n, int16_t *code, float *temp, uint8_t *flags);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_SERIES Multi Sensor Filtering */           /** @{ */
+
+/**
+   Function for initializing filter state for n sensors.
+   
+   @params:
+       series         - state
+       n              - number of sensors
+       ewma, tMin,
+       tMax, flags    - caller arrays of n entries
+       shift          - EWMA alpha = 2^-shift ( 0 - 15 )
+       tLower, tUpper - alert thresholds in 1/16C applied to the EWMA
+*/
+void thermo8_seriesInit(T_thermo8_series *series, uint16_t n, int32_t *ewma, int16_t *tMin,
+                        int16_t *tMax, uint8_t *flags, uint8_t shift, int16_t tLower, int16_t tUpper);
+
+/**
+   Function for advancing all sensors with one scan of codes.
+   
+   EWMA, min / max and threshold flags are updated in a single pass over
+   the arrays, code[ i ] is the new TA of sensor i in 1/16C.
+   
+   @return:
+       number of sensors outside the thresholds
+*/
+uint16_t thermo8_seriesUpdate(T_thermo8_series *series, const int16_t *code);
+
+/**
+   Function for reading the filtered temperature of sensor i in 1/16C.
+*/
+int16_t thermo8_seriesValue(const T_thermo8_series *series, uint16_t i);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_ARCH Sample Archive */                     /** @{ */
+
+/**
+   Function for initializing an empty archive over nBlocks blocks.
+*/
+void thermo8_archInit(T_thermo8_archive *arch, T_thermo8_archBlock *blocks, uint16_t nBlocks);
+
+/**
+   Function for appending a sample, the block indexes are kept up to date.
+   
+   @return:
+       0 - stored, 1 - archive full
+*/
+uint8_t thermo8_archAppend(T_thermo8_archive *arch, const T_thermo8_sample *sample);
+
+/**
+   Function for scanning a time and temperature range. Blocks whose index
+   does not overlap the range are skipped without touching their columns.
+   
+   @params:
+       arch   - archive
+       t0, t1 - time range in ms, inclusive
+       c0, c1 - TA range in 1/16C, inclusive
+       fn     - called for every matching sample, may be 0 to count only
+       
+   @return:
+       number of matching samples
+*/
+uint32_t thermo8_archScan(const T_thermo8_archive *arch, uint32_t t0, uint32_t t1,
+                          int16_t c0, int16_t c1, T_thermo8_archFp fn);
+
+/**
+   Function for serializing a block, independent of the MCU byte order and
+   structure padding. All fields are little endian :
+   
+       0  magic 'T' '8' 'A' 'B'
+       4  version, 1
+       5  reserved, 0
+       6  count, uint16
+       8  codeMin, codeMax, int16
+       12 timeMin, timeMax, uint32
+       20 time column, count x uint32
+          code column, count x int16
+          dev column, count bytes
+          flags column, count bytes
+   
+   @params:
+       blk - block
+       buf - destination, up to THERMO8_ARCH_IMAGE_MAX bytes
+       
+   @return:
+       image length, 20 + 8 * count bytes
+*/
+uint16_t thermo8_archBlockWrite(const T_thermo8_archBlock *blk, uint8_t *buf);
+
+/**
+   Function for parsing a block image written by thermo8_archBlockWrite().
+   
+   @params:
+       blk - destination block
+       buf - image
+       len - bytes available at buf
+       
+   @return:
+       0 - parsed, 1 - bad magic, version or count, or image truncated
+*/
+uint8_t thermo8_archBlockRead(T_thermo8_archBlock *blk, const uint8_t *buf, uint16_t len);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_GROUP Sensor Groups */                    /** @{ */
+
+/**
+   Function for initializing a sensor group.
+   
+   @params:
+       group  - group
+       idx    - member positions in the scan array ( e.g. thermo8_readAll )
+       n      - number of members, 1 - 8
+       k      - outlier threshold in MADs, 3 flags readings about two
+                standard deviations away
+       madMin - smallest MAD used in 1/16C, keeps agreeing sensors
+                from being flagged for tiny differences, e.g. 4 ( 0.25C )
+*/
+void thermo8_groupInit(T_thermo8_group *group, const uint8_t *idx, uint8_t n, uint8_t k, int16_t madMin);
+
+/**
+   Function for evaluating a group after a scan.
+   
+   @params:
+       group - group
+       tRaw  - scan, TA in 1/16C
+       valid - per scan position, 0 - no reading, may be 0 for all valid
+       zone  - result
+       
+   @return:
+       members used for the mean
+       
+   Integer arithmetic on stack buffers only, the median and MAD use an
+   insertion sort of at most 8 values. At least 3 valid members are
+   needed to single out a sensor.
+*/
+uint8_t thermo8_groupEval(const T_thermo8_group *group, const int16_t *tRaw, const uint8_t *valid, T_thermo8_zone *zone);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_STATS Streaming Statistics */              /** @{ */
+
+/**
+   Function for clearing the statistics accumulator.
+*/
+void thermo8_statsReset(T_thermo8_stats *stats);
+
+/**
+   Function for adding one raw temperature code to the accumulator.
+   
+   @params:
+       stats - accumulator
+       tRaw  - temperature in 1/16C as returned by thermo8_getTemperatureRaw()
+       
+   @note:
+       Once THERMO8_STATS_MAX_COUNT samples are accumulated further samples
+       only update the minimum and maximum, count, mean and variance stay
+       as they are. Merge the window into a longer one and reset it instead.
+*/
+void thermo8_statsUpdate(T_thermo8_stats *stats, int16_t tRaw);
+
+/**
+   Function for merging the src accumulator into dst.
+   Per-minute windows can be combined into hourly ones this way.
+*/
+void thermo8_statsMerge(T_thermo8_stats *dst, const T_thermo8_stats *src);
+
+/**
+   Function will return the window mean in 1/256C.
+*/
+int32_t thermo8_statsMean(const T_thermo8_stats *stats);
+
+/**
+   Function will return the window (population) variance in (1/256C)^2.
+*/
+uint32_t thermo8_statsVariance(const T_thermo8_stats *stats);
+
+/**
+   Function will return the window standard deviation in 1/256C.
+*/
+uint16_t thermo8_statsStddev(const T_thermo8_stats *stats);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_BUS Bus Discovery */                       /** @{ */
+
+/**
+   Function will probe addresses THERMO8_ADDR0 - THERMO8_ADDR7, verify the
+   MANID ( 0x0054 ) and DEVID ( 0x04xx ) of each device and cache the
+   resulting inventory.
+   
+   @return:
+       bit mask of verified devices, bit n is THERMO8_ADDR0 + n
+*/
+uint8_t thermo8_discover();
+
+/**
+   Function will refresh the cached inventory with a single DEVID read
+   per address. Only devices which were not present before get their
+   MANID verified again.
+   
+   @return:
+       bit mask of verified devices
+*/
+uint8_t thermo8_rescan();
+
+/**
+   Function will return the cached inventory.
+*/
+const T_thermo8_inventory* thermo8_getInventory();
+
+/**
+   Function will return 1 if the device at the given slave address is
+   present in the cached inventory.
+*/
+uint8_t thermo8_isPresent(uint8_t slave);
+
+/**
+   Function will read the temperature of every device in the cached
+   inventory. Absent addresses are skipped without touching the bus.
+   
+   @params:
+       tRaw - array of 8 temperatures in 1/16C, indexed by address - THERMO8_ADDR0
+       
+   @return:
+       bit mask of devices which were read
+*/
+uint8_t thermo8_readAll(int16_t *tRaw);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_PROFILE Configuration Profiles */          /** @{ */
+
+/**
+   Function will apply the configuration profile to the selected device.
+   All register images are computed up front, only registers which differ
+   from the cached state are written and the lock bits are set last
+   together with the final CONFIG value. Limit registers locked by
+   CRIT_LOCK or WIN_LOCK are not written, they have to hold the profile
+   value already.
+   
+   @return:
+       0 - profile applied, THERMO8_ERR_LOCKED if a locked limit differs
+       from the profile, else the HAL error code of the first failed
+       access. Nothing after the error is written ( 1 without a selected
+       device ).
+*/
+int thermo8_profileApply(const T_thermo8_profile *profile);
+
+/**
+   Function will apply the configuration profile to every device in the
+   cached inventory ( see thermo8_discover() ). A device which fails, or
+   holds a locked limit that differs from the profile, is left out of the
+   mask, thermo8_getError() returns the first error.
+   
+   @return:
+       bit mask of devices which took the whole profile
+*/
+uint8_t thermo8_profileApplyAll(const T_thermo8_profile *profile);
+
+/**
+   Function will drop the cached register state, the next profile apply
+   will write every register.
+*/
+void thermo8_cacheInvalidate();
+
+/**
+   Warm boot check for the selected device. CONFIG, RESOLUTION and the
+   three limit registers are read back to back and compared against the
+   profile. Nothing is written.
+   
+   @return:
+       1 - the sensor already runs with the profile, configuration and the
+           power-up delay can be skipped
+       0 - the profile has to be applied
+*/
+uint8_t thermo8_warmBootCheck(const T_thermo8_profile *profile);
+
+                                                                       /** @} */
+/** @defgroup THERMO8_PRED Time-to-threshold Prediction */       /** @{ */
+
+/**
+   Function for initializing the predictor.
+   
+   @params:
+       pred     - predictor
+       periodMs - time between two thermo8_predUpdate() calls, 0 is
+                  taken as 1 ms
+       tUpper   - TUPPER limit in 1/16C
+       tCrit    - TCRIT limit in 1/16C
+*/
+void thermo8_predInit(T_thermo8_pred *pred, uint16_t periodMs, int16_t tUpper, int16_t tCrit);
+
+/**
+   Function for loading the TUPPER and TCRIT limits from the sensor
+   into the predictor.
+*/
+void thermo8_predLoadLimits(T_thermo8_pred *pred);
+
+/**
+   Function for registering the callback which will be called once the
+   predicted time to TUPPER or TCRIT drops below leadSec seconds.
+   The callback is armed again when the prediction rises above the lead time.
+*/
+void thermo8_predSetCallback(T_thermo8_pred *pred, uint16_t leadSec, T_thermo8_predCb cb);
+
+/**
+   Function for adding a new sample to the predictor.
+   
+   @params:
+       pred - predictor
+       tRaw - temperature in 1/16C as returned by thermo8_getTemperatureRaw()
+*/
+void thermo8_predUpdate(T_thermo8_pred *pred, int16_t tRaw);
+
+/**
+   Function will return the estimated seconds until the limit is crossed.
+   
+   @params:
+       pred         - predictor
+       limitRegaddr - THERMO8_TUPPER or THERMO8_TCRIT
+       
+   @return:
+       0 if the fitted temperature is already at the limit,
+       THERMO8_PRED_NEVER if the trend does not approach the limit.
 */
-void thermo8_winUnlock();
+uint16_t thermo8_predSeconds(T_thermo8_pred *pred, uint8_t limitRegaddr);
 
 
 
@@ -72,6 +72,13 @@
 // #define   __TX_PIN_OUTPUT__         9
 // #define   __SCL_PIN_OUTPUT__        10                                    
 // #define   __SDA_PIN_OUTPUT__        11    
+
+#ifdef __THERMO8_BUS_SOFT__
+  #define   __SCL_PIN_INPUT__         10
+  #define   __SDA_PIN_INPUT__         11
+  #define   __SCL_PIN_OUTPUT__        10
+  #define   __SDA_PIN_OUTPUT__        11
+#endif
                                                                        /** @} */
 #ifdef __HAL_SPI__
 
@@ -0,0 +1,77 @@
+/*
+    Sample archive benchmark, ingest rate and narrow time range scans
+    against a linear pass over the same samples.
+*/
+#include "thermo8_sim.h"
+#include <time.h>
+
+#define BLOCKS      4096
+#define SAMPLES     ( BLOCKS * THERMO8_ARCH_BLOCK )
+#define QUERIES     2000
+
+static T_thermo8_archBlock blocks[ BLOCKS ];
+static T_thermo8_sample    flat[ SAMPLES ];
+
+static double elapsed(struct timespec *t0)
+{
+    struct timespec t1;
+
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+    return ( t1.tv_sec - t0->tv_sec ) * 1e9 + ( t1.tv_nsec - t0->tv_nsec );
+}
+
+int main()
+{
+    T_thermo8_archive arch;
+    T_thermo8_sample s;
+    struct timespec t0;
+    uint32_t from;
+    uint32_t hits = 0;
+    uint32_t ref = 0;
+    double ns;
+    long i;
+    long q;
+
+    thermo8_archInit( &arch, blocks, BLOCKS );
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( i = 0; i < SAMPLES; i++ )
+    {
+        s.timeMs = (uint32_t)i * 10;
+        s.tRaw   = (int16_t)( 400 + ( i % 50 ) );
+        s.dev    = (uint8_t)( i & 0x07 );
+        s.flags  = 0;
+        flat[ i ] = s;
+        thermo8_archAppend( &arch, &s );
+    }
+    ns = elapsed( &t0 );
+    printf( "ingest       : %.1f ns per sample\n", ns / SAMPLES );
+
+    /* one minute windows */
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( q = 0; q < QUERIES; q++ )
+    {
+        from = (uint32_t)( q * 7919L % SAMPLES ) * 10;
+        hits += thermo8_archScan( &arch, from, from + 59999, 420, 439, 0 );
+    }
+    ns = elapsed( &t0 );
+    printf( "indexed scan : %.0f ns per query\n", ns / QUERIES );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( q = 0; q < QUERIES; q++ )
+    {
+        from = (uint32_t)( q * 7919L % SAMPLES ) * 10;
+        for( i = 0; i < SAMPLES; i++ )
+        {
+            if( ( flat[ i ].timeMs >= from ) && ( flat[ i ].timeMs <= from + 59999 ) &&
+                ( flat[ i ].tRaw >= 420 ) && ( flat[ i ].tRaw <= 439 ) )
+            {
+                ref++;
+            }
+        }
+    }
+    ns = elapsed( &t0 );
+    printf( "linear scan  : %.0f ns per query\n", ns / QUERIES );
+    CHECK( hits == ref );
+
+    return sim_done( "bench_arch" );
+}
@@ -0,0 +1,51 @@
+/*
+    Bus binding comparison, HAL function pointers against the compile time
+    binding. Built twice, bench_bus_static defines SIM_BUS_STATIC.
+
+    Host wall clock time through the simulator says nothing about the
+    target, so the benchmark counts what the binding changes: calls
+    dispatched through the HAL function pointers per TA read. Each one is
+    an indirect call the target compiler can neither inline nor resolve
+    at build time.
+*/
+#ifdef SIM_BUS_STATIC
+#define __THERMO8_BUS_STATIC__
+#define THERMO8_BUS_START()                     sim_start()
+#define THERMO8_BUS_WRITE(addr, buf, n, mode)   sim_write(addr, buf, n, mode)
+#define THERMO8_BUS_READ(addr, buf, n, mode)    sim_read(addr, buf, n, mode)
+#define THERMO8_INT_GET()                       sim_intGet()
+#endif
+#include "thermo8_sim.h"
+
+#define READS   100000L
+
+int main()
+{
+    long i;
+    long sum = 0;
+
+    sim_attach( SIM_ADDR_BASE );
+    sim_halCalls = 0;
+    sim_starts = 0;
+    for( i = 0; i < READS; i++ )
+    {
+        sum += thermo8_getTemperatureRaw();
+    }
+
+#ifdef SIM_BUS_STATIC
+    printf( "static bus binding : " );
+#else
+    printf( "HAL function ptrs  : " );
+#endif
+    printf( "%.2f HAL dispatches per TA read\n", (double)sim_halCalls / READS );
+    CHECK( sum == 400L * READS );
+    CHECK( sim_starts == READS );
+    CHECK( thermo8_getError() == 0 );
+#ifdef SIM_BUS_STATIC
+    CHECK( sim_halCalls == 0 );
+#else
+    CHECK( sim_halCalls == 3 * READS );
+#endif
+
+    return sim_done( "bench_bus" );
+}
@@ -0,0 +1,108 @@
+/*
+    Batch decoding benchmark, thermo8_decodeBatch against per sample
+    _btoTconversion() loops over the same TA words.
+
+    The word count is a run time value, as for the stored arrays on the
+    analytics side. The first per sample loop lets the compiler inline the
+    conversion, the second calls it out of line like an application linked
+    against a separately compiled driver. The batch float path has to beat
+    both.
+*/
+#include "thermo8_sim.h"
+#include <time.h>
+
+#define WORDS   32768U
+#define PASSES  2000L
+
+static uint16_t raw[ WORDS ];
+static int16_t  code[ WORDS ];
+static float    temp[ WORDS ];
+static uint8_t  flags[ WORDS ];
+
+static volatile uint16_t words = WORDS;
+static float (* volatile conv)(uint16_t rData) = _btoTconversion;
+
+static double elapsed(struct timespec *t0)
+{
+    struct timespec t1;
+
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+    return ( t1.tv_sec - t0->tv_sec ) * 1e9 + ( t1.tv_nsec - t0->tv_nsec );
+}
+
+int main()
+{
+    struct timespec t0;
+    volatile float sink = 0;
+    float (*fp)(uint16_t rData) = conv;
+    uint16_t n = words;
+    double batch;
+    double inl;
+    double call;
+    double ns;
+    long p;
+    uint16_t i;
+
+    for( i = 0; i < WORDS; i++ )
+    {
+        raw[ i ] = (uint16_t)( i * 40503U );
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( p = 0; p < PASSES; p++ )
+    {
+        thermo8_decodeBatch( raw, n, code, 0, 0 );
+        sink += code[ p % WORDS ];
+    }
+    ns = elapsed( &t0 );
+    printf( "batch, code         : %.2f ns per word\n", ns / ( PASSES * WORDS ) );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( p = 0; p < PASSES; p++ )
+    {
+        thermo8_decodeBatch( raw, n, code, temp, flags );
+        sink += temp[ p % WORDS ] + flags[ p % WORDS ];
+    }
+    ns = elapsed( &t0 );
+    printf( "batch, all outputs  : %.2f ns per word\n", ns / ( PASSES * WORDS ) );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( p = 0; p < PASSES; p++ )
+    {
+        thermo8_decodeBatch( raw, n, 0, temp, 0 );
+        sink += temp[ p % WORDS ];
+    }
+    batch = elapsed( &t0 );
+    printf( "batch, float        : %.2f ns per word\n", batch / ( PASSES * WORDS ) );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( p = 0; p < PASSES; p++ )
+    {
+        for( i = 0; i < n; i++ )
+        {
+            temp[ i ] = _btoTconversion( raw[ i ] );
+        }
+        sink += temp[ p % WORDS ];
+    }
+    inl = elapsed( &t0 );
+    printf( "per sample, inlined : %.2f ns per word, batch %.1fx faster\n",
+            inl / ( PASSES * WORDS ), inl / batch );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( p = 0; p < PASSES; p++ )
+    {
+        for( i = 0; i < n; i++ )
+        {
+            temp[ i ] = fp( raw[ i ] );
+        }
+        sink += temp[ p % WORDS ];
+    }
+    call = elapsed( &t0 );
+    printf( "per sample, call    : %.2f ns per word, batch %.1fx faster\n",
+            call / ( PASSES * WORDS ), call / batch );
+    CHECK( sink == sink );
+    CHECK( batch < inl );
+    CHECK( batch < call );
+
+    return sim_done( "bench_decode" );
+}
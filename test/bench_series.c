@@ -0,0 +1,62 @@
+/*
+    Multi sensor filtering benchmark, thermo8_seriesUpdate over ten
+    thousand sensors. The gateway target is 10k series per millisecond on
+    one core.
+*/
+#include "thermo8_sim.h"
+#include <time.h>
+
+#define N       10000U
+#define SCANS   2000L
+
+static int32_t ewma[ N ];
+static int16_t tMin[ N ];
+static int16_t tMax[ N ];
+static uint8_t flags[ N ];
+static int16_t code[ 16 ][ N ];
+
+static double elapsed(struct timespec *t0)
+{
+    struct timespec t1;
+
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+    return ( t1.tv_sec - t0->tv_sec ) * 1e9 + ( t1.tv_nsec - t0->tv_nsec );
+}
+
+int main()
+{
+    T_thermo8_series series;
+    struct timespec t0;
+    uint32_t seed = 1;
+    long alerts = 0;
+    double rate;
+    double ns;
+    long s;
+    uint16_t i;
+    uint8_t k;
+
+    /* sixteen scans of noisy codes around the thresholds, replayed in turn */
+    for( k = 0; k < 16; k++ )
+    {
+        for( i = 0; i < N; i++ )
+        {
+            seed = seed * 1103515245UL + 12345UL;
+            code[ k ][ i ] = (int16_t)( 400 + ( seed >> 16 ) % 801 - 400 );
+        }
+    }
+    thermo8_seriesInit( &series, N, ewma, tMin, tMax, flags, 4, 100, 700 );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( s = 0; s < SCANS; s++ )
+    {
+        alerts += thermo8_seriesUpdate( &series, code[ s & 15 ] );
+    }
+    ns = elapsed( &t0 );
+    rate = (double)N * SCANS / ( ns / 1e6 );
+    printf( "%.2f ns per series, %.0f series per ms, %ld alerts\n",
+            ns / ( (double)N * SCANS ), rate, alerts );
+    CHECK( alerts > 0 );
+    CHECK( rate >= 10000.0 );
+
+    return sim_done( "bench_series" );
+}
@@ -0,0 +1,42 @@
+/*
+    Software I2C benchmark, pin operations and simulated bus time per TA
+    read with the default half bit time, plus the host time spent in the
+    bit-banging code ( model included ).
+*/
+#define __THERMO8_BUS_SOFT__
+#include "thermo8_sim.h"
+#include "thermo8_soft.h"
+#include <time.h>
+
+#define READS   200000L
+
+int main()
+{
+    struct timespec t0, t1;
+    uint32_t ns0;
+    long ops0;
+    long sum = 0;
+    long i;
+    double ns;
+
+    pin_attach( SIM_ADDR_BASE );
+    ops0 = pin_ops;
+    ns0  = sim_ns;
+    sum += thermo8_getTemperatureRaw();
+    printf( "pin ops per TA read    : %ld\n", pin_ops - ops0 );
+    printf( "bus time per TA read   : %lu us ( HALF_US %d )\n",
+            (unsigned long)( ( sim_ns - ns0 ) / 1000 ), THERMO8_SOFT_HALF_US );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    for( i = 1; i < READS; i++ )
+    {
+        sum += thermo8_getTemperatureRaw();
+    }
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+    ns = ( t1.tv_sec - t0.tv_sec ) * 1e9 + ( t1.tv_nsec - t0.tv_nsec );
+    printf( "host time per TA read  : %.0f ns\n", ns / ( READS - 1 ) );
+    CHECK( sum == 400L * READS );
+    CHECK( thermo8_getError() == 0 );
+
+    return sim_done( "bench_soft_i2c" );
+}
@@ -0,0 +1,159 @@
+/*
+    Paced acquisition and sample queues
+
+    One acquisition feeds a fast and a slow consumer from the simulated
+    bus, then a producer and a consumer thread run a queue flat out to
+    check the lock free hand over.
+*/
+#include "thermo8_sim.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define SPSC_SAMPLES    2000000L
+
+static T_thermo8_ring spscRing;
+
+static void *producer(void *arg)
+{
+    T_thermo8_sample s;
+    long i;
+
+    ( void )arg;
+    for( i = 0; i < SPSC_SAMPLES; )
+    {
+        s.timeMs = (uint32_t)i;
+        s.tRaw   = (int16_t)( i * 7 );
+        s.dev    = (uint8_t)( i & 0x07 );
+        s.flags  = (uint8_t)( i >> 3 );
+        if( ( uint8_t )( spscRing.head - spscRing.tail ) < THERMO8_RING_LEN )
+        {
+            thermo8_ringPush( &spscRing, &s );
+            i++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+static void *consumer(void *arg)
+{
+    T_thermo8_sample s;
+    long bad = 0;
+    long i;
+
+    ( void )arg;
+    for( i = 0; i < SPSC_SAMPLES; )
+    {
+        if( !thermo8_ringPop( &spscRing, &s ) )
+        {
+            sched_yield();
+            continue;
+        }
+        if( ( s.timeMs != (uint32_t)i ) || ( s.tRaw != (int16_t)( i * 7 ) ) ||
+            ( s.dev != ( i & 0x07 ) ) || ( s.flags != (uint8_t)( i >> 3 ) ) )
+        {
+            bad++;
+        }
+        i++;
+    }
+    return (void*)bad;
+}
+
+int main()
+{
+    T_thermo8_profile profile;
+    T_thermo8_acq acq;
+    T_thermo8_ring fast;
+    T_thermo8_ring slow;
+    T_thermo8_sample s;
+    pthread_t th[ 2 ];
+    void *ret;
+    uint32_t now;
+    long nFast = 0;
+    long nSlow = 0;
+    long order = 0;
+    uint32_t last[ 8 ] = { 0 };
+
+    memset( &profile, 0, sizeof( profile ) );
+    sim_attach( SIM_ADDR_BASE );
+    CHECK( thermo8_discover() == 0xFF );
+
+    /* 30 ms conversions on every device */
+    CHECK( thermo8_acqInit( &acq, 0 ) == 0 );
+    CHECK( acq.periodMs == 250 );
+    profile.resolution = 0;
+    CHECK( thermo8_profileApplyAll( &profile ) == 0xFF );
+    CHECK( thermo8_acqInit( &acq, 0 ) == 0 );
+    CHECK( acq.periodMs == 30 );
+    CHECK( thermo8_acqInit( &acq, 20 ) == 1 );
+    CHECK( thermo8_acqInit( &acq, 30 ) == 0 );
+
+    thermo8_ringInit( &fast );
+    thermo8_ringInit( &slow );
+    CHECK( thermo8_acqAddConsumer( &acq, &fast ) == 0 );
+    CHECK( thermo8_acqAddConsumer( &acq, &slow ) == 0 );
+
+    for( now = 1000; now < 4000; now++ )
+    {
+        thermo8_acqPoll( &acq, now );
+        while( thermo8_ringPop( &fast, &s ) )
+        {
+            if( s.timeMs < last[ s.dev ] )
+            {
+                order++;
+            }
+            last[ s.dev ] = s.timeMs;
+            nFast++;
+        }
+        if( now % 100 == 0 )
+        {
+            while( thermo8_ringPop( &slow, &s ) )
+            {
+                nSlow++;
+            }
+        }
+    }
+    while( thermo8_ringPop( &slow, &s ) )
+    {
+        nSlow++;
+    }
+    printf( "cycles %lu samples %lu fast %ld slow %ld dropped %lu lagMax %lu\n",
+            (unsigned long)acq.cycles, (unsigned long)acq.samples, nFast, nSlow,
+            (unsigned long)slow.dropped, (unsigned long)acq.lagMax );
+    CHECK( acq.cycles == 100 );
+    CHECK( acq.samples == 800 );
+    CHECK( nFast == 800 );
+    CHECK( order == 0 );
+    CHECK( fast.dropped == 0 );
+    CHECK( nSlow + (long)slow.dropped == 800 );
+    CHECK( acq.overruns == 0 );
+    CHECK( acq.lagMax == 0 );
+
+    /* a stalled caller skips the missed cycles */
+    thermo8_acqPoll( &acq, 4500 );
+    CHECK( acq.lagLast == 4500 - 4000 );
+    CHECK( acq.overruns == 16 );
+    CHECK( acq.next == 4510 );
+
+    /* failed reads are counted, the other devices are still published */
+    sim_nackAddr  = SIM_ADDR_BASE + 5;
+    sim_nackCount = -1;
+    CHECK( thermo8_acqPoll( &acq, 4510 ) == 0xDF );
+    CHECK( acq.errors == 1 );
+    sim_nackAddr = -1;
+
+    /* lock free hand over between two threads */
+    thermo8_ringInit( &spscRing );
+    pthread_create( &th[ 0 ], 0, producer, 0 );
+    pthread_create( &th[ 1 ], 0, consumer, 0 );
+    pthread_join( th[ 0 ], 0 );
+    pthread_join( th[ 1 ], &ret );
+    printf( "spsc %ld samples, %ld bad\n", SPSC_SAMPLES, (long)ret );
+    CHECK( (long)ret == 0 );
+    CHECK( spscRing.dropped == 0 );
+
+    return sim_done( "test_acq" );
+}
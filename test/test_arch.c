@@ -0,0 +1,168 @@
+/*
+    Sample archive
+
+    Fills an archive with a drifting temperature trace, checks the full
+    condition and compares range scans against a brute force pass over a
+    flat copy of the samples. Block images are compared byte by byte with
+    the documented little endian layout and must survive a round trip.
+*/
+#include "thermo8_sim.h"
+
+#define BLOCKS      64
+#define SAMPLES     ( BLOCKS * THERMO8_ARCH_BLOCK )
+#define QUERIES     2000
+
+static T_thermo8_archBlock blocks[ BLOCKS ];
+static T_thermo8_sample    flat[ SAMPLES ];
+static uint32_t            seed = 1;
+
+static uint32_t rnd()
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return seed >> 8;
+}
+
+/* two samples, { 0x12345678 ms, -2 } and { 0x9ABCDEF0 ms, 0x0190 } */
+static const uint8_t image[ 36 ] =
+{
+    'T', '8', 'A', 'B', 1, 0, 0x02, 0x00,
+    0xFE, 0xFF, 0x90, 0x01,
+    0x78, 0x56, 0x34, 0x12, 0xF0, 0xDE, 0xBC, 0x9A,
+    0x78, 0x56, 0x34, 0x12, 0xF0, 0xDE, 0xBC, 0x9A,
+    0xFE, 0xFF, 0x90, 0x01,
+    0x03, 0x05,
+    0x0C, 0x30
+};
+
+static uint8_t blockEqual(const T_thermo8_archBlock *a, const T_thermo8_archBlock *b)
+{
+    uint16_t i;
+
+    if( ( a->count != b->count ) || ( a->codeMin != b->codeMin ) || ( a->codeMax != b->codeMax ) ||
+        ( a->timeMin != b->timeMin ) || ( a->timeMax != b->timeMax ) )
+    {
+        return 0;
+    }
+    for( i = 0; i < a->count; i++ )
+    {
+        if( ( a->time[ i ] != b->time[ i ] ) || ( a->code[ i ] != b->code[ i ] ) ||
+            ( a->dev[ i ] != b->dev[ i ] ) || ( a->flags[ i ] != b->flags[ i ] ) )
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint32_t qt0, qt1;
+static int16_t  qc0, qc1;
+static long     outside;
+
+static void visit(const T_thermo8_sample *s)
+{
+    if( ( s->timeMs < qt0 ) || ( s->timeMs > qt1 ) || ( s->tRaw < qc0 ) || ( s->tRaw > qc1 ) )
+    {
+        outside++;
+    }
+}
+
+int main()
+{
+    T_thermo8_archive arch;
+    T_thermo8_sample s;
+    uint32_t hits;
+    uint32_t ref;
+    int16_t t = 400;
+    long i;
+    long q;
+
+    thermo8_archInit( &arch, blocks, BLOCKS );
+    CHECK( thermo8_archScan( &arch, 0, 0xFFFFFFFFUL, -4096, 4095, 0 ) == 0 );
+
+    for( i = 0; i < SAMPLES; i++ )
+    {
+        t += (int16_t)( rnd() % 9 ) - 4;
+        s.timeMs = (uint32_t)i * 10 + rnd() % 10;
+        s.tRaw   = t;
+        s.dev    = (uint8_t)( i & 0x07 );
+        s.flags  = (uint8_t)( rnd() & 0x07 );
+        flat[ i ] = s;
+        CHECK( thermo8_archAppend( &arch, &s ) == 0 );
+    }
+    CHECK( thermo8_archAppend( &arch, &s ) == 1 );
+    CHECK( arch.used == BLOCKS );
+    CHECK( thermo8_archScan( &arch, 0, 0xFFFFFFFFUL, -4096, 4095, 0 ) == SAMPLES );
+
+    for( q = 0; q < QUERIES; q++ )
+    {
+        qt0 = rnd() % ( SAMPLES * 10 );
+        qt1 = qt0 + rnd() % ( SAMPLES * 10 / ( 1 + q % 16 ) );
+        qc0 = (int16_t)( 200 + rnd() % 400 );
+        qc1 = (int16_t)( qc0 + rnd() % 200 );
+        ref = 0;
+        for( i = 0; i < SAMPLES; i++ )
+        {
+            if( ( flat[ i ].timeMs >= qt0 ) && ( flat[ i ].timeMs <= qt1 ) &&
+                ( flat[ i ].tRaw >= qc0 ) && ( flat[ i ].tRaw <= qc1 ) )
+            {
+                ref++;
+            }
+        }
+        hits = thermo8_archScan( &arch, qt0, qt1, qc0, qc1, visit );
+        CHECK( hits == ref );
+    }
+    CHECK( outside == 0 );
+
+    /* byte exact layout */
+    {
+        T_thermo8_archive small;
+        T_thermo8_archBlock blk;
+        T_thermo8_archBlock back;
+        uint8_t buf[ THERMO8_ARCH_IMAGE_MAX ];
+        uint8_t buf2[ THERMO8_ARCH_IMAGE_MAX ];
+        uint16_t len;
+
+        thermo8_archInit( &small, &blk, 1 );
+        s.timeMs = 0x12345678UL;
+        s.tRaw   = -2;
+        s.dev    = 3;
+        s.flags  = 0x0C;
+        thermo8_archAppend( &small, &s );
+        s.timeMs = 0x9ABCDEF0UL;
+        s.tRaw   = 0x0190;
+        s.dev    = 5;
+        s.flags  = 0x30;
+        thermo8_archAppend( &small, &s );
+        CHECK( thermo8_archBlockWrite( &blk, buf ) == sizeof( image ) );
+        CHECK( memcmp( buf, image, sizeof( image ) ) == 0 );
+        memset( &back, 0xAA, sizeof( back ) );
+        CHECK( thermo8_archBlockRead( &back, image, sizeof( image ) ) == 0 );
+        CHECK( blockEqual( &back, &blk ) );
+
+        /* rejected images */
+        memcpy( buf, image, sizeof( image ) );
+        CHECK( thermo8_archBlockRead( &back, buf, sizeof( image ) - 1 ) == 1 );
+        CHECK( thermo8_archBlockRead( &back, buf, 19 ) == 1 );
+        buf[ 4 ] = 2;
+        CHECK( thermo8_archBlockRead( &back, buf, sizeof( image ) ) == 1 );
+        buf[ 4 ] = 1;
+        buf[ 0 ] = 't';
+        CHECK( thermo8_archBlockRead( &back, buf, sizeof( image ) ) == 1 );
+        buf[ 0 ] = 'T';
+        buf[ 6 ] = THERMO8_ARCH_BLOCK + 1;
+        CHECK( thermo8_archBlockRead( &back, buf, THERMO8_ARCH_IMAGE_MAX ) == 1 );
+
+        /* round trip of every full block */
+        for( i = 0; i < BLOCKS; i++ )
+        {
+            len = thermo8_archBlockWrite( &blocks[ i ], buf );
+            CHECK( len == THERMO8_ARCH_IMAGE_MAX );
+            CHECK( thermo8_archBlockRead( &back, buf, len ) == 0 );
+            CHECK( blockEqual( &back, &blocks[ i ] ) );
+            CHECK( thermo8_archBlockWrite( &back, buf2 ) == len );
+            CHECK( memcmp( buf, buf2, len ) == 0 );
+        }
+    }
+
+    return sim_done( "test_arch" );
+}
@@ -0,0 +1,40 @@
+/*
+    Compile time bus binding, the driver calls the bus macros directly.
+*/
+#define __THERMO8_BUS_STATIC__
+#define THERMO8_BUS_START()                     sim_start()
+#define THERMO8_BUS_WRITE(addr, buf, n, mode)   sim_write(addr, buf, n, mode)
+#define THERMO8_BUS_READ(addr, buf, n, mode)    sim_read(addr, buf, n, mode)
+#define THERMO8_INT_GET()                       sim_intGet()
+#include "thermo8_sim.h"
+
+/* the HAL path must not be reached */
+static int halStart()
+{
+    CHECK( 0 );
+    return 1;
+}
+
+int main()
+{
+    long starts;
+
+    sim_attach( SIM_ADDR_BASE );
+    sim_startFp = halStart;
+    sim_dev[ SIM_ADDR_BASE + 3 ].present = 0;
+
+    CHECK( thermo8_discover() == 0xF7 );
+    CHECK( thermo8_getTemperatureRaw() == 400 );
+    CHECK( thermo8_getManid() == 0x0054 );
+
+    starts = sim_starts;
+    CHECK( thermo8_writeReg( THERMO8_REG_TCRIT, 0x0320 ) == 0 );
+    CHECK( sim_dev[ SIM_ADDR_BASE ].reg[ 4 ] == 0x0320 );
+    CHECK( sim_starts == starts + 1 );
+
+    sim_int = 0;
+    CHECK( thermo8_aleGet() == 0 );
+    CHECK( thermo8_getError() == 0 );
+
+    return sim_done( "test_bus_static" );
+}
@@ -0,0 +1,92 @@
+/*
+    Bus lock stress test
+
+    Eight threads hammer their own sensor through the reentrant thermo8_dev*
+    functions while sharing one bus. The simulated bus counts transactions
+    which start while another one is still running, there must be none, and
+    every thread has to read its own device.
+*/
+#include "thermo8_sim.h"
+#include <pthread.h>
+
+#define THREADS     8
+#define LOOPS       50000
+
+static pthread_mutex_t busMutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile long   lockDepth;
+static volatile long   lockNested;
+
+static void busLock()
+{
+    pthread_mutex_lock( &busMutex );
+    if( ++lockDepth != 1 )
+    {
+        lockNested++;
+    }
+}
+
+static void busUnlock()
+{
+    lockDepth--;
+    pthread_mutex_unlock( &busMutex );
+}
+
+static void *sensorThread(void *arg)
+{
+    T_thermo8_dev dev;
+    long bad = 0;
+    long i;
+    int16_t t;
+
+    thermo8_devInit( &dev, (uint8_t)(long)arg );
+    for( i = 0; i < LOOPS; i++ )
+    {
+        t = thermo8_devGetTemperatureRaw( &dev );
+        if( ( t != 400 + ( dev.slave - SIM_ADDR_BASE ) ) || thermo8_devGetError( &dev ) )
+        {
+            bad++;
+        }
+        if( ( i & 0xFF ) == 0 )
+        {
+            thermo8_devWriteReg( &dev, THERMO8_REG_TUPPER, 0x01C0 + dev.slave );
+        }
+    }
+    return (void*)bad;
+}
+
+int main()
+{
+    pthread_t th[ THREADS ];
+    void *ret;
+    long bad = 0;
+    long i;
+
+    sim_attach( SIM_ADDR_BASE );
+    for( i = 0; i < THREADS; i++ )
+    {
+        sim_dev[ SIM_ADDR_BASE + i ].reg[ 5 ] = 0x0190 + i;
+    }
+    thermo8_busLockSet( busLock, busUnlock );
+
+    for( i = 0; i < THREADS; i++ )
+    {
+        pthread_create( &th[ i ], 0, sensorThread, (void*)( SIM_ADDR_BASE + i ) );
+    }
+    for( i = 0; i < THREADS; i++ )
+    {
+        pthread_join( th[ i ], &ret );
+        bad += (long)ret;
+    }
+
+    printf( "%d threads x %d reads, %ld transactions, %ld overlaps, %ld bad reads\n",
+            THREADS, LOOPS, sim_starts, sim_overlaps, bad );
+    CHECK( sim_overlaps == 0 );
+    CHECK( lockNested == 0 );
+    CHECK( bad == 0 );
+    for( i = 0; i < THREADS; i++ )
+    {
+        CHECK( sim_dev[ SIM_ADDR_BASE + i ].reg[ 2 ] == 0x01C0 + SIM_ADDR_BASE + i );
+    }
+
+    return sim_done( "test_buslock" );
+}
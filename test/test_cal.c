@@ -0,0 +1,128 @@
+/*
+    Two point calibration
+
+    Q14 gains from thermo8_calFromPoints are checked against the exact
+    line through the reference points. The forward correction of every
+    TA code is compared with double precision, the reverse conversion
+    used for the limits must invert it to within one code, and limits
+    programmed on a calibrated sensor must fire at the calibrated
+    temperature to within the 0.25 C register resolution.
+*/
+#include "thermo8_sim.h"
+#include <math.h>
+#include <stdlib.h>
+
+static int16_t codes[ 8192 ];
+
+/* raw code ref1 / ref2 pairs, slope from 0.5 to 2.0 and both offset signs */
+static const int16_t points[][ 4 ] =
+{
+    {    0,   16,  800,  816 },
+    {  400,  410, 1200, 1225 },
+    { -320, -300,  960,  940 },
+    {  100,  -40,  900,  360 },
+    { -800, -900,  400, 1500 },
+    {  160,  200,  176,  216 },
+};
+
+static double exact(const T_thermo8_cal *cal, int16_t code)
+{
+    return code * ( cal->gain / 16384.0 ) + cal->offset;
+}
+
+int main()
+{
+    T_thermo8_cal cal;
+    T_thermo8_cal calv[ 8192 ];
+    double slope;
+    long bad = 0;
+    int16_t c;
+    int16_t r;
+    uint16_t k;
+    int i;
+    long j;
+
+    sim_attach( SIM_ADDR_BASE );
+
+    /* rejected point pairs */
+    CHECK( thermo8_calFromPoints( &cal, 400, 400, 410, 410 ) == 1 );     /* < 1 C apart */
+    CHECK( thermo8_calFromPoints( &cal, 400, 800, 800, 400 ) == 1 );     /* falling */
+    CHECK( thermo8_calFromPoints( &cal, 0, 0, 100, 400 ) == 1 );         /* gain 4.0 */
+    CHECK( thermo8_calFromPoints( &cal, 0, 0, 100, 399 ) == 0 );
+    CHECK( cal.gain == 65372 );
+
+    for( i = 0; i < (int)( sizeof( points ) / sizeof( points[ 0 ] ) ); i++ )
+    {
+        CHECK( thermo8_calFromPoints( &cal, points[ i ][ 0 ], points[ i ][ 1 ],
+                                      points[ i ][ 2 ], points[ i ][ 3 ] ) == 0 );
+        /* gain rounded to Q14, the first point exact, the second within a code */
+        slope = (double)( points[ i ][ 3 ] - points[ i ][ 1 ] ) / ( points[ i ][ 2 ] - points[ i ][ 0 ] );
+        CHECK( fabs( cal.gain - slope * 16384.0 ) <= 0.5 );
+        CHECK( _calApply( &cal, points[ i ][ 0 ] ) == points[ i ][ 1 ] );
+        CHECK( abs( _calApply( &cal, points[ i ][ 2 ] ) - points[ i ][ 3 ] ) <= 1 );
+
+        /* forward over the whole TA range, rounded to the nearest code */
+        for( j = 0; j < 8192; j++ )
+        {
+            codes[ j ] = (int16_t)( j - 4096 );
+            calv[ j ] = cal;
+        }
+        thermo8_calBatch( calv, codes, 8192 );
+        for( j = 0; j < 8192; j++ )
+        {
+            if( fabs( codes[ j ] - exact( &cal, (int16_t)( j - 4096 ) ) ) > 0.5 )
+            {
+                bad++;
+            }
+        }
+
+        /* reverse, the raw code closest to the calibrated temperature */
+        thermo8_calSet( SIM_ADDR_BASE, &cal );
+        for( c = -2000; c <= 2000; c++ )
+        {
+            r = _calRev( SIM_ADDR_BASE, c );
+            if( fabs( ( c - cal.offset ) * 16384.0 / cal.gain - r ) > 0.5 )
+            {
+                bad++;
+            }
+            if( abs( _calFwd( SIM_ADDR_BASE, r ) - c ) > (int)( cal.gain / 32768 ) + 1 )
+            {
+                bad++;
+            }
+        }
+
+        /* calibrated limits, the register decodes within half a step of the target */
+        CHECK( thermo8_windowSet( 480, 320, 960 ) == 0 );
+        for( k = 2; k <= 4; k++ )
+        {
+            c = ( k == 2 ) ? 480 : ( ( k == 3 ) ? 320 : 960 );
+            r = _rawToCode( sim_dev[ SIM_ADDR_BASE ].reg[ k ] );
+            CHECK( ( r & 0x03 ) == 0 );
+            CHECK( fabs( exact( &cal, r ) - c ) <= 2.0 * cal.gain / 16384.0 + 0.5 );
+        }
+
+        /* readings come back calibrated */
+        sim_dev[ SIM_ADDR_BASE ].reg[ 5 ] = 0x0190;
+        CHECK( thermo8_getTemperatureRaw() == _calApply( &cal, 400 ) );
+        CHECK( thermo8_getTemperatue() == _calApply( &cal, 400 ) / 16.0f );
+    }
+    CHECK( bad == 0 );
+
+    /* reverse results far outside the sensor range are clamped */
+    cal.gain   = 8192;
+    cal.offset = 0;
+    thermo8_calSet( SIM_ADDR_BASE, &cal );
+    CHECK( _calRev( SIM_ADDR_BASE, 30000 ) == 0x3FFF );
+    CHECK( _calRev( SIM_ADDR_BASE, -30000 ) == -0x4000 );
+
+    /* removing the calibration restores raw readings */
+    thermo8_calSet( SIM_ADDR_BASE, 0 );
+    CHECK( thermo8_getTemperatureRaw() == 400 );
+    CHECK( _calRev( SIM_ADDR_BASE, 123 ) == 123 );
+    cal.gain = 0;
+    codes[ 0 ] = -77;
+    thermo8_calBatch( &cal, codes, 1 );
+    CHECK( codes[ 0 ] == -77 );
+
+    return sim_done( "test_cal" );
+}
@@ -0,0 +1,112 @@
+/*
+    Batch decoding
+
+    Every possible TA word is decoded by thermo8_decodeBatch and compared
+    bit for bit against the datasheet formula, _btoTconversion and the
+    alert flag mapping, for every combination of the optional outputs.
+*/
+#include "thermo8_sim.h"
+
+#define WORDS   65536L
+#define HALF    32768U
+
+static uint16_t raw[ WORDS ];
+static int16_t  code[ WORDS ];
+static int16_t  code2[ WORDS ];
+static float    temp[ WORDS ];
+static float    temp2[ WORDS ];
+static uint8_t  flags[ WORDS ];
+static uint8_t  flags2[ WORDS ];
+
+/* MCP9808 datasheet, equation 5-1 */
+static float refTemp(uint16_t w)
+{
+    float t;
+
+    t = ( ( w >> 8 ) & 0x0F ) * 16.0f + ( w & 0xFF ) / 16.0f;
+    if( w & 0x1000 )
+    {
+        t -= 256.0f;
+    }
+    return t;
+}
+
+static uint8_t refFlags(uint16_t w)
+{
+    uint8_t f = 0;
+
+    if( w & 0x8000 )
+    {
+        f |= THERMO8_TCRIT_REACHED;
+    }
+    if( w & 0x4000 )
+    {
+        f |= THERMO8_TUPPER_REACHED;
+    }
+    if( w & 0x2000 )
+    {
+        f |= THERMO8_TLOWER_REACHED;
+    }
+    return f;
+}
+
+int main()
+{
+    long bad = 0;
+    long i;
+
+    for( i = 0; i < WORDS; i++ )
+    {
+        raw[ i ] = (uint16_t)i;
+    }
+    thermo8_decodeBatch( raw, HALF, code, temp, flags );
+    thermo8_decodeBatch( raw + HALF, HALF, code + HALF, temp + HALF, flags + HALF );
+
+    for( i = 0; i < WORDS; i++ )
+    {
+        if( ( temp[ i ] != refTemp( raw[ i ] ) ) || ( code[ i ] / 16.0f != temp[ i ] ) ||
+            ( temp[ i ] != _btoTconversion( raw[ i ] ) ) || ( flags[ i ] != refFlags( raw[ i ] ) ) )
+        {
+            bad++;
+        }
+    }
+    CHECK( bad == 0 );
+
+    /* code only, odd length */
+    memset( code2, 0x55, sizeof( code2 ) );
+    thermo8_decodeBatch( raw, 12345, code2, 0, 0 );
+    CHECK( memcmp( code2, code, 12345 * sizeof( int16_t ) ) == 0 );
+    CHECK( code2[ 12345 ] == 0x5555 );
+
+    /* flags only */
+    memset( flags, 0, sizeof( flags ) );
+    thermo8_decodeBatch( raw, HALF, 0, 0, flags );
+    for( i = 0; i < HALF; i++ )
+    {
+        if( flags[ i ] != refFlags( raw[ i ] ) )
+        {
+            bad++;
+        }
+    }
+    CHECK( bad == 0 );
+    thermo8_decodeBatch( raw, 0, code2, temp, flags );
+
+    /* every output combination, odd length, nothing written past n */
+    thermo8_decodeBatch( raw + HALF, HALF, 0, 0, flags + HALF );
+    for( i = 1; i < 8; i++ )
+    {
+        memset( code2, 0x55, sizeof( code2 ) );
+        memset( temp2, 0x55, sizeof( temp2 ) );
+        memset( flags2, 0x55, sizeof( flags2 ) );
+        thermo8_decodeBatch( raw, 40001, ( i & 1 ) ? code2 : 0, ( i & 2 ) ? temp2 : 0,
+                             ( i & 4 ) ? flags2 : 0 );
+        CHECK( memcmp( code2, code, ( i & 1 ) ? 40001 * sizeof( int16_t ) : 0 ) == 0 );
+        CHECK( memcmp( temp2, temp, ( i & 2 ) ? 40001 * sizeof( float ) : 0 ) == 0 );
+        CHECK( memcmp( flags2, flags, ( i & 4 ) ? 40001 : 0 ) == 0 );
+        CHECK( code2[ ( i & 1 ) ? 40001 : 0 ] == 0x5555 );
+        CHECK( flags2[ ( i & 4 ) ? 40001 : 0 ] == 0x55 );
+        CHECK( memcmp( &temp2[ ( i & 2 ) ? 40001 : 0 ], &temp2[ WORDS - 1 ], sizeof( float ) ) == 0 );
+    }
+
+    return sim_done( "test_decode" );
+}
@@ -0,0 +1,110 @@
+/*
+    Shared ALERT line
+
+    The ALERT outputs of the sensors are wired together on the INT pin,
+    the line is low while any sensor asserts its output. The demultiplexer
+    has to find the sensors that fired, clear them in interrupt mode, stop
+    querying once the line is released and try the last offenders first.
+*/
+#include "thermo8_sim.h"
+
+#define CFG_INT     ( THERMO8_CFG_ALERT_MOD | THERMO8_CFG_ALERT_CNT )
+
+/* wired OR of the open drain, active low outputs */
+static uint8_t wiredOr()
+{
+    int i;
+
+    for( i = SIM_ADDR_BASE; i < SIM_ADDR_BASE + 8; i++ )
+    {
+        if( sim_dev[ i ].present && ( sim_dev[ i ].reg[ 1 ] & THERMO8_CFG_ALERT_CNT ) &&
+            ( sim_dev[ i ].reg[ 1 ] & THERMO8_CFG_ALERT_STAT ) )
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void fire(int i, uint16_t ta)
+{
+    sim_dev[ SIM_ADDR_BASE + i ].reg[ 1 ] |= THERMO8_CFG_ALERT_STAT;
+    sim_dev[ SIM_ADDR_BASE + i ].reg[ 5 ] = ta;
+}
+
+static uint8_t asserted(int i)
+{
+    return ( sim_dev[ SIM_ADDR_BASE + i ].reg[ 1 ] & THERMO8_CFG_ALERT_STAT ) != 0;
+}
+
+int main()
+{
+    T_thermo8_demux demux;
+    int i;
+
+    sim_attach( SIM_ADDR_BASE );
+    sim_gpio.gpioGet[ 7 ] = wiredOr;
+    thermo8_i2cDriverInit( (T_THERMO8_P)&sim_gpio, (T_THERMO8_P)0, SIM_ADDR_BASE );
+    sim_dev[ SIM_ADDR_BASE + 7 ].present = 0;
+    CHECK( thermo8_discover() == 0x7F );
+    for( i = 0; i < 7; i++ )
+    {
+        sim_dev[ SIM_ADDR_BASE + i ].reg[ 1 ] = CFG_INT;
+    }
+    thermo8_demuxInit( &demux );
+
+    /* idle line, nothing is queried */
+    sim_starts = 0;
+    CHECK( thermo8_demuxAlert( &demux ) == 0 );
+    CHECK( demux.reads == 0 );
+    CHECK( sim_starts == 0 );
+
+    /* no history, sensors are queried in address order until 5 is cleared */
+    fire( 5, THERMO8_TA_UPPER | 0x01D0 );
+    CHECK( thermo8_demuxAlert( &demux ) == 0x20 );
+    CHECK( demux.reads == 6 + 1 );
+    CHECK( demux.flags[ 5 ] == THERMO8_TUPPER_REACHED );
+    CHECK( !asserted( 5 ) );
+    CHECK( wiredOr() );
+
+    /* the last offender is queried first */
+    fire( 5, THERMO8_TA_CRIT | THERMO8_TA_UPPER | 0x0640 );
+    sim_starts = 0;
+    CHECK( thermo8_demuxAlert( &demux ) == 0x20 );
+    CHECK( demux.reads == 2 );
+    CHECK( sim_starts == 3 );
+    CHECK( demux.flags[ 5 ] == ( THERMO8_TCRIT_REACHED | THERMO8_TUPPER_REACHED ) );
+
+    /* two sensors, 5 first, then address order until both are cleared */
+    fire( 1, THERMO8_TA_LOWER | 0x0010 );
+    fire( 3, THERMO8_TA_UPPER | 0x01D0 );
+    CHECK( thermo8_demuxAlert( &demux ) == 0x0A );
+    CHECK( demux.flags[ 1 ] == THERMO8_TLOWER_REACHED );
+    CHECK( demux.flags[ 3 ] == THERMO8_TUPPER_REACHED );
+    CHECK( !asserted( 1 ) && !asserted( 3 ) );
+    CHECK( demux.reads == 1 + 1 + 2 + 1 + 2 );
+
+    /* 1 and 3 fired last and come before 5 */
+    fire( 3, THERMO8_TA_UPPER | 0x01D0 );
+    CHECK( thermo8_demuxAlert( &demux ) == 0x08 );
+    CHECK( demux.reads == 1 + 2 );
+    CHECK( demux.hits[ 5 ] == 2 );
+    CHECK( demux.hits[ 3 ] == 2 );
+    CHECK( demux.hits[ 1 ] == 1 );
+
+    /* a comparator mode output stays asserted, every sensor is queried once */
+    sim_dev[ SIM_ADDR_BASE + 6 ].reg[ 1 ] = THERMO8_CFG_ALERT_CNT;
+    fire( 6, THERMO8_TA_UPPER | 0x01D0 );
+    CHECK( thermo8_demuxAlert( &demux ) == 0x40 );
+    CHECK( asserted( 6 ) );
+    CHECK( demux.reads == 7 + 1 );
+    CHECK( sim_dev[ SIM_ADDR_BASE + 6 ].reg[ 1 ] == ( THERMO8_CFG_ALERT_CNT | THERMO8_CFG_ALERT_STAT ) );
+
+    /* the absent sensor 7 is never addressed */
+    sim_nackAddr = SIM_ADDR_BASE + 7;
+    sim_nackCount = -1;
+    CHECK( thermo8_demuxAlert( &demux ) == 0x40 );
+    CHECK( thermo8_getError() == 0 );
+
+    return sim_done( "test_demux" );
+}
@@ -0,0 +1,86 @@
+/*
+    Bus error handling
+
+    Failed starts are retried like NACKs, the legacy read-modify-write
+    calls never write CONFIG after a failed read, and discovery probes
+    absent addresses once without touching the retry budget.
+*/
+#include "thermo8_sim.h"
+
+int main()
+{
+    T_thermo8_busStats stats;
+    T_thermo8_muxDev list[ 8 ];
+    long starts;
+    uint32_t ns;
+    int a;
+
+    sim_attach( SIM_ADDR_BASE );
+    thermo8_retrySet( 2 );
+
+    /* a failed start is retried */
+    sim_startFail = 2;
+    CHECK( thermo8_readReg( THERMO8_REG_TA ) == 0x0190 );
+    CHECK( thermo8_getError() == 0 );
+    thermo8_busStatsGet( &stats );
+    CHECK( stats.retries == 2 );
+    CHECK( sim_startFail == 0 );
+
+    /* ... within the budget */
+    sim_startFail = 3;
+    thermo8_readReg( THERMO8_REG_TA );
+    CHECK( thermo8_getError() != 0 );
+    CHECK( sim_startFail == 0 );
+
+    /* nothing is written after a failed CONFIG read */
+    thermo8_retrySet( 0 );
+    sim_dev[ SIM_ADDR_BASE ].reg[ 1 ] = 0x0000;
+    sim_nackAddr  = SIM_ADDR_BASE;
+    sim_nackCount = 1;
+    ns = sim_ns;
+    CHECK( thermo8_sleep() != 0 );
+    CHECK( sim_dev[ SIM_ADDR_BASE ].reg[ 1 ] == 0x0000 );
+    CHECK( sim_ns == ns );
+    CHECK( thermo8_getError() != 0 );
+    sim_nackCount = 1;
+    CHECK( thermo8_tcritLock() != 0 );
+    sim_nackCount = 1;
+    CHECK( thermo8_winLock() != 0 );
+    CHECK( sim_dev[ SIM_ADDR_BASE ].reg[ 1 ] == 0x0000 );
+    thermo8_getError();
+
+    CHECK( thermo8_sleep() == 0 );
+    CHECK( sim_dev[ SIM_ADDR_BASE ].reg[ 1 ] == 0x0100 );
+    CHECK( thermo8_wakeup() == 0 );
+    CHECK( sim_dev[ SIM_ADDR_BASE ].reg[ 1 ] == 0x0000 );
+    CHECK( thermo8_getError() == 0 );
+
+    /* discovery probes once, the retry budget stays as set */
+    thermo8_retrySet( 3 );
+    sim_dev[ SIM_ADDR_BASE + 3 ].present = 0;
+    starts = sim_starts;
+    CHECK( thermo8_discover() == 0xF7 );
+    CHECK( sim_starts - starts == 7 * 2 + 1 );
+    CHECK( _retries == 3 );
+    CHECK( thermo8_getError() == 0 );
+
+    /* multiplexer writes are retried, absent channels probed once */
+    sim_muxPresent = 0x01;
+    sim_devInit( &sim_chan[ 0 ][ 2 ][ SIM_ADDR_BASE + 5 ] );
+    sim_dev[ SIM_ADDR_BASE + 5 ].present = 0;
+    sim_nackAddr  = SIM_MUX_BASE;
+    sim_nackCount = 2;
+    CHECK( thermo8_muxSelect( SIM_MUX_BASE, 2 ) == 0 );
+    CHECK( sim_muxCtl[ 0 ] == 0x04 );
+    CHECK( thermo8_muxRelease() == 0 );
+    sim_dev[ SIM_ADDR_BASE + 5 ].present = 1;
+    for( a = SIM_ADDR_BASE; a < SIM_ADDR_BASE + 8; a++ )
+    {
+        sim_dev[ a ].present = 0;
+    }
+    CHECK( thermo8_muxDiscover( SIM_MUX_BASE, list, 8 ) == 1 );
+    CHECK( ( list[ 0 ].channel == 2 ) && ( list[ 0 ].slave == SIM_ADDR_BASE + 5 ) );
+    CHECK( _retries == 3 );
+
+    return sim_done( "test_errors" );
+}
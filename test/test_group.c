@@ -0,0 +1,197 @@
+/*
+    Redundant sensor groups
+
+    Hand picked zones check the outlier rule, the member bits, the
+    madMin floor and the small group cases. Random groups with gaps in
+    the scan and negative temperatures are then compared with a reference
+    built on qsort, median of the sorted values, MAD of the sorted
+    deviations and the mean of the members kept, rounded half away from
+    zero.
+*/
+#include "thermo8_sim.h"
+#include <stdlib.h>
+#include <math.h>
+
+#define GROUPS  20000
+
+static uint32_t seed = 3;
+
+static uint32_t rnd()
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return seed >> 8;
+}
+
+static int cmp(const void *a, const void *b)
+{
+    return *(const int16_t *)a - *(const int16_t *)b;
+}
+
+static int16_t refMedian(int16_t *v, int n)
+{
+    qsort( v, n, sizeof( int16_t ), cmp );
+    return ( n & 1 ) ? v[ n / 2 ] : (int16_t)floor( ( v[ n / 2 - 1 ] + v[ n / 2 ] ) / 2.0 );
+}
+
+int main()
+{
+    T_thermo8_group group;
+    T_thermo8_zone zone;
+    int16_t tRaw[ 16 ];
+    uint8_t valid[ 16 ];
+    uint8_t idx[ 8 ];
+    int16_t val[ 8 ];
+    int16_t dev[ 8 ];
+    uint8_t pos[ 8 ];
+    int16_t median;
+    int16_t mad;
+    int32_t sum;
+    int32_t lim;
+    uint8_t outliers;
+    uint8_t used;
+    long bad = 0;
+    long flagged = 0;
+    long g;
+    int n;
+    int m;
+    int i;
+
+    /* one of five sensors stuck at 85 C */
+    for( i = 0; i < 5; i++ )
+    {
+        idx[ i ] = (uint8_t)( 2 * i + 1 );
+    }
+    tRaw[ 1 ] = 400;
+    tRaw[ 3 ] = 404;
+    tRaw[ 5 ] = 1360;
+    tRaw[ 7 ] = 396;
+    tRaw[ 9 ] = 401;
+    thermo8_groupInit( &group, idx, 5, 3, 4 );
+    CHECK( thermo8_groupEval( &group, tRaw, 0, &zone ) == 4 );
+    CHECK( zone.median == 401 );
+    CHECK( zone.mad == 3 );
+    CHECK( zone.outliers == 0x04 );
+    CHECK( zone.used == 5 );
+    CHECK( zone.mean == 400 );
+
+    /* without member 0 the bits still follow the member order */
+    memset( valid, 1, sizeof( valid ) );
+    valid[ 1 ] = 0;
+    CHECK( thermo8_groupEval( &group, tRaw, valid, &zone ) == 3 );
+    CHECK( zone.used == 4 );
+    CHECK( zone.outliers == 0x04 );
+    CHECK( zone.median == 402 );
+    CHECK( zone.mean == 400 );
+
+    /* tight agreement, madMin keeps a 0.25 C difference in */
+    tRaw[ 1 ] = tRaw[ 3 ] = tRaw[ 5 ] = tRaw[ 7 ] = 400;
+    tRaw[ 9 ] = 404;
+    CHECK( thermo8_groupEval( &group, tRaw, 0, &zone ) == 5 );
+    CHECK( zone.mad == 0 );
+    CHECK( zone.outliers == 0 );
+    thermo8_groupInit( &group, idx, 5, 3, 1 );
+    CHECK( thermo8_groupEval( &group, tRaw, 0, &zone ) == 4 );
+    CHECK( zone.outliers == 0x10 );
+
+    /* two sensors can not single one out, the median is their midpoint */
+    thermo8_groupInit( &group, idx, 2, 3, 1 );
+    tRaw[ 1 ] = -3;
+    tRaw[ 3 ] = 800;
+    CHECK( thermo8_groupEval( &group, tRaw, 0, &zone ) == 2 );
+    CHECK( zone.outliers == 0 );
+    CHECK( zone.median == 398 );
+    CHECK( zone.mean == 399 );
+
+    /* negative mean, ties away from zero */
+    tRaw[ 1 ] = -3;
+    tRaw[ 3 ] = -4;
+    CHECK( thermo8_groupEval( &group, tRaw, 0, &zone ) == 2 );
+    CHECK( zone.median == -4 );
+    CHECK( zone.mean == -4 );
+
+    /* nothing valid */
+    memset( valid, 0, sizeof( valid ) );
+    CHECK( thermo8_groupEval( &group, tRaw, valid, &zone ) == 0 );
+    CHECK( ( zone.used == 0 ) && ( zone.median == 0 ) && ( zone.mean == 0 ) && ( zone.mad == 0 ) );
+
+    /* more than 8 members are cut to 8 */
+    thermo8_groupInit( &group, idx, 12, 3, 4 );
+    CHECK( group.n == 8 );
+
+    for( g = 0; g < GROUPS; g++ )
+    {
+        n = 1 + rnd() % 8;
+        for( i = 0; i < 16; i++ )
+        {
+            tRaw[ i ] = (int16_t)( -200 + rnd() % 64 );
+            valid[ i ] = ( rnd() % 8 ) != 0;
+        }
+        /* occasional far off readings */
+        if( rnd() % 2 )
+        {
+            tRaw[ rnd() % 16 ] = (int16_t)( rnd() % 2 ? 2000 : -2000 );
+        }
+        for( i = 0; i < n; i++ )
+        {
+            idx[ i ] = (uint8_t)( rnd() % 16 );
+        }
+        thermo8_groupInit( &group, idx, n, 1 + rnd() % 4, rnd() % 6 );
+        used = thermo8_groupEval( &group, tRaw, valid, &zone );
+
+        m = 0;
+        for( i = 0; i < n; i++ )
+        {
+            if( valid[ idx[ i ] ] )
+            {
+                pos[ m ] = (uint8_t)i;
+                val[ m++ ] = tRaw[ idx[ i ] ];
+            }
+        }
+        if( m == 0 )
+        {
+            if( ( used != 0 ) || ( zone.used != 0 ) || zone.outliers )
+            {
+                bad++;
+            }
+            continue;
+        }
+        memcpy( dev, val, sizeof( dev ) );
+        median = refMedian( dev, m );
+        for( i = 0; i < m; i++ )
+        {
+            dev[ i ] = (int16_t)abs( val[ i ] - median );
+        }
+        mad = refMedian( dev, m );
+        lim = (int32_t)group.k * ( mad > group.madMin ? mad : group.madMin );
+        outliers = 0;
+        sum = 0;
+        for( i = 0; i < m; i++ )
+        {
+            if( abs( val[ i ] - median ) > lim )
+            {
+                outliers |= 1 << pos[ i ];
+            }
+            else
+            {
+                sum += val[ i ];
+            }
+        }
+        i = m - __builtin_popcount( outliers );
+        if( ( zone.used != m ) || ( zone.median != median ) || ( zone.mad != mad ) ||
+            ( zone.outliers != outliers ) || ( used != i ) ||
+            ( zone.mean != ( i ? (int16_t)( sum >= 0 ? ( sum + i / 2 ) / i : -( ( -sum + i / 2 ) / i ) )
+                               : median ) ) )
+        {
+            bad++;
+        }
+        if( outliers )
+        {
+            flagged++;
+        }
+    }
+    printf( "%ld random groups, %ld with outliers\n", (long)GROUPS, flagged );
+    CHECK( bad == 0 );
+    CHECK( flagged > GROUPS / 10 );
+
+    return sim_done( "test_group" );
+}
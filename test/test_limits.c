@@ -0,0 +1,79 @@
+/*
+    Limit programming
+
+    The float, quarter degree and 1/16 degree paths have to program the
+    same register for the same threshold, ties included. windowSet is
+    checked with negative and tie values, cached skips and locks.
+*/
+#include "thermo8_sim.h"
+
+int main()
+{
+    T_sim_dev *d;
+    long starts;
+    long bad = 0;
+    int code;
+    uint16_t viaFloat;
+
+    sim_attach( SIM_ADDR_BASE );
+    d = &sim_dev[ SIM_ADDR_BASE ];
+
+    /* every 1/16 C code, float against integer */
+    for( code = -4096; code < 4096; code++ )
+    {
+        thermo8_limitSet( THERMO8_TUPPER, code / 16.0f );
+        viaFloat = d->reg[ 2 ];
+        thermo8_limitSetQ4( THERMO8_TUPPER, (int16_t)code );
+        if( d->reg[ 2 ] != viaFloat )
+        {
+            bad++;
+        }
+    }
+    CHECK( bad == 0 );
+    for( code = -1024; code < 1024; code++ )
+    {
+        thermo8_limitSetQ2( THERMO8_TLOWER, (int16_t)code );
+        if( d->reg[ 3 ] != THERMO8_LIMIT( code ) )
+        {
+            bad++;
+        }
+    }
+    CHECK( bad == 0 );
+
+    /* ties go away from zero on both sides */
+    thermo8_limitSetQ4( THERMO8_TUPPER, -2 );
+    CHECK( d->reg[ 2 ] == THERMO8_LIMIT( -1 ) );
+    thermo8_limitSet( THERMO8_TUPPER, -0.125f );
+    CHECK( d->reg[ 2 ] == THERMO8_LIMIT( -1 ) );
+    thermo8_limitSetQ4( THERMO8_TUPPER, 2 );
+    CHECK( d->reg[ 2 ] == THERMO8_LIMIT( 1 ) );
+    thermo8_limitSetQ4( THERMO8_TUPPER, -1 );
+    CHECK( d->reg[ 2 ] == THERMO8_LIMIT( 0 ) );
+    thermo8_limitSetQ4( THERMO8_TUPPER, -3 );
+    CHECK( d->reg[ 2 ] == THERMO8_LIMIT( -1 ) );
+
+    /* windowSet, negative values and ties */
+    thermo8_cacheInvalidate();
+    CHECK( thermo8_windowSet( -2, -10 * 16 - 6, 2 ) == 0 );
+    CHECK( d->reg[ 2 ] == THERMO8_LIMIT( -1 ) );
+    CHECK( d->reg[ 3 ] == THERMO8_LIMIT( -10 * 4 - 2 ) );
+    CHECK( d->reg[ 4 ] == THERMO8_LIMIT( 1 ) );
+    CHECK( thermo8_windowSet( -2, -10 * 16 - 6, 2 ) == 0 );
+    thermo8_limitSet( THERMO8_TLOWER, -10.375f );
+    CHECK( d->reg[ 3 ] == THERMO8_LIMIT( -10 * 4 - 2 ) );
+
+    /* registers which already hold the value are not written */
+    starts = sim_starts;
+    CHECK( thermo8_windowSet( -2, -10 * 16 - 6, 2 ) == 0 );
+    CHECK( sim_starts == starts );
+
+    /* the window lock keeps TUPPER / TLOWER, TCRIT still moves */
+    thermo8_winLock();
+    thermo8_cacheInvalidate();
+    CHECK( thermo8_windowSet( 30 * 16, -10 * 16 - 6, 90 * 16 ) == THERMO8_WIN_UPPER );
+    CHECK( d->reg[ 2 ] == THERMO8_LIMIT( -1 ) );
+    CHECK( d->reg[ 4 ] == THERMO8_LIMIT( 90 * 4 ) );
+    CHECK( thermo8_getError() == 0 );
+
+    return sim_done( "test_limits" );
+}
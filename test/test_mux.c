@@ -0,0 +1,195 @@
+/*
+    TCA9548A multiplexers
+
+    Two multiplexers carry sensors on equal addresses. Checks discovery and
+    ordering, one multiplexer write per channel and scan, that equal
+    addresses never meet on the bus, the bus lock span of a multiplexed
+    access, the register cache bypass and the error paths of a failed
+    disconnect.
+*/
+#include "thermo8_sim.h"
+
+static volatile int lockDepth;
+static long lockCalls;
+static long unlocked;
+
+static void busLock()
+{
+    lockDepth++;
+    lockCalls++;
+}
+
+static void busUnlock()
+{
+    lockDepth--;
+}
+
+/* every transaction has to run inside one lock span */
+static int lockedStart()
+{
+    if( lockDepth != 1 )
+    {
+        unlocked++;
+    }
+    return sim_start();
+}
+
+static int lockedWrite(uint8_t addr, uint8_t *buf, uint16_t n, uint8_t mode)
+{
+    if( lockDepth != 1 )
+    {
+        unlocked++;
+    }
+    return sim_write( addr, buf, n, mode );
+}
+
+static int16_t expected(const T_thermo8_muxDev *d)
+{
+    return (int16_t)( ( d->mux & 0x07 ) * 256 + d->channel * 16 + d->slave - SIM_ADDR_BASE );
+}
+
+int main()
+{
+    T_thermo8_muxDev list[ 80 ];
+    T_thermo8_muxDev tmp;
+    int16_t tRaw[ 80 ];
+    uint16_t v;
+    uint8_t n;
+    uint8_t n1;
+    int bad = 0;
+    int m;
+    int c;
+    int a;
+    int i;
+    int j;
+
+    sim_attach( SIM_ADDR_BASE );
+    for( a = SIM_ADDR_BASE; a < SIM_ADDR_BASE + 8; a++ )
+    {
+        sim_dev[ a ].present = 0;
+    }
+    sim_muxPresent = 0x03;
+    for( m = 0; m < 2; m++ )
+    {
+        for( c = 0; c < 8; c++ )
+        {
+            for( a = SIM_ADDR_BASE; a < SIM_ADDR_BASE + 8; a++ )
+            {
+                /* mux 1 only has sensors on the even channels, four each */
+                if( m && ( ( c & 1 ) || ( a >= SIM_ADDR_BASE + 4 ) ) )
+                {
+                    continue;
+                }
+                sim_devInit( &sim_chan[ m ][ c ][ a ] );
+                sim_chan[ m ][ c ][ a ].reg[ 5 ] = m * 256 + c * 16 + a - SIM_ADDR_BASE;
+            }
+        }
+    }
+    thermo8_busLockSet( busLock, busUnlock );
+    sim_startFp = lockedStart;
+    sim_writeFp = lockedWrite;
+
+    /* discovery, sorted by channel */
+    n  = thermo8_muxDiscover( SIM_MUX_BASE, list, 64 );
+    n1 = thermo8_muxDiscover( SIM_MUX_BASE + 1, list + n, 80 - n );
+    CHECK( n == 64 );
+    CHECK( n1 == 16 );
+    for( i = 1; i < n + n1; i++ )
+    {
+        if( _muxKey( &list[ i - 1 ] ) > _muxKey( &list[ i ] ) )
+        {
+            bad++;
+        }
+    }
+    CHECK( bad == 0 );
+    CHECK( thermo8_muxDiscover( SIM_MUX_BASE + 2, list + n + n1, 1 ) == 0 );
+
+    /* one multiplexer write per channel and scan */
+    sim_muxWrites = 0;
+    CHECK( thermo8_muxReadAll( list, n + n1, tRaw ) == n + n1 );
+    for( i = 0; i < n + n1; i++ )
+    {
+        if( tRaw[ i ] != expected( &list[ i ] ) )
+        {
+            bad++;
+        }
+    }
+    CHECK( bad == 0 );
+    printf( "%d devices, %ld multiplexer writes per sorted scan\n", n + n1, sim_muxWrites );
+    CHECK( sim_muxWrites <= 8 + 4 + 1 );
+
+    /* a shuffled list reads the same, sorting restores the write count */
+    for( i = 0; i < n + n1; i++ )
+    {
+        j = ( i * 37 + 11 ) % ( n + n1 );
+        tmp = list[ i ];
+        list[ i ] = list[ j ];
+        list[ j ] = tmp;
+    }
+    CHECK( thermo8_muxReadAll( list, n + n1, tRaw ) == n + n1 );
+    for( i = 0; i < n + n1; i++ )
+    {
+        if( tRaw[ i ] != expected( &list[ i ] ) )
+        {
+            bad++;
+        }
+    }
+    CHECK( bad == 0 );
+    thermo8_muxSort( list, n + n1 );
+    sim_muxWrites = 0;
+    thermo8_muxReadAll( list, n + n1, tRaw );
+    CHECK( sim_muxWrites <= 8 + 4 + 1 );
+    CHECK( sim_collisions == 0 );
+    CHECK( ( sim_muxCtl[ 0 ] == 0 ) || ( sim_muxCtl[ 1 ] == 0 ) );
+
+    /* one lock span per access, covering the selection */
+    thermo8_muxRelease();
+    lockCalls = 0;
+    CHECK( thermo8_muxReadReg( &list[ 5 ], THERMO8_REG_TA, &v ) == 0 );
+    CHECK( v == (uint16_t)expected( &list[ 5 ] ) );
+    CHECK( lockCalls == 1 );
+    CHECK( thermo8_muxWriteReg( &list[ 70 ], THERMO8_REG_TUPPER, 0x0123 ) == 0 );
+    CHECK( sim_chan[ list[ 70 ].mux & 0x07 ][ list[ 70 ].channel ][ list[ 70 ].slave ].reg[ 2 ] == 0x0123 );
+    CHECK( lockCalls == 2 );
+    CHECK( unlocked == 0 );
+    CHECK( lockDepth == 0 );
+
+    /* registers read through a channel never reach the cache */
+    thermo8_cacheInvalidate();
+    CHECK( thermo8_muxReadReg( &list[ 0 ], THERMO8_REG_CONFIG, &v ) == 0 );
+    CHECK( thermo8_muxReadReg( &list[ 0 ], THERMO8_REG_RESOLUTION, &v ) == 0 );
+    for( i = 0; i < 8; i++ )
+    {
+        CHECK( _regCache[ i ].valid == 0 );
+    }
+
+    /* a failed disconnect selects nothing else */
+    CHECK( thermo8_muxReadReg( &list[ 0 ], THERMO8_REG_TA, &v ) == 0 );
+    sim_nackAddr  = SIM_MUX_BASE;
+    sim_nackCount = -1;
+    sim_muxWrites = 0;
+    CHECK( thermo8_muxReadReg( &list[ 70 ], THERMO8_REG_TA, &v ) != 0 );
+    CHECK( list[ 70 ].err != 0 );
+    CHECK( sim_muxWrites == 0 );
+    CHECK( sim_muxCtl[ 1 ] == 0 );
+    CHECK( thermo8_muxRelease() != 0 );
+    sim_nackCount = 0;
+    CHECK( thermo8_muxRelease() == 0 );
+    CHECK( ( sim_muxCtl[ 0 ] == 0 ) && ( sim_muxCtl[ 1 ] == 0 ) );
+    CHECK( thermo8_muxReadReg( &list[ 70 ], THERMO8_REG_TA, &v ) == 0 );
+    CHECK( list[ 70 ].err == 0 );
+
+    /* a directly wired device is reached with every channel released */
+    sim_devInit( &sim_dev[ SIM_ADDR_BASE ] );
+    sim_dev[ SIM_ADDR_BASE ].reg[ 5 ] = 0x0AAA;
+    tmp.mux = 0;
+    tmp.channel = 0;
+    tmp.slave = SIM_ADDR_BASE;
+    CHECK( thermo8_muxReadReg( &tmp, THERMO8_REG_TA, &v ) == 0 );
+    CHECK( v == 0x0AAA );
+    CHECK( ( sim_muxCtl[ 0 ] == 0 ) && ( sim_muxCtl[ 1 ] == 0 ) );
+    CHECK( sim_collisions == 0 );
+    CHECK( unlocked == 0 );
+
+    return sim_done( "test_mux" );
+}
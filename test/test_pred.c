@@ -0,0 +1,112 @@
+/*
+    Time-to-threshold prediction
+
+    Feeds linear ramps to the predictor and checks the fitted slope through
+    the time to TUPPER / TCRIT, long horizons, the trend cases without a
+    crossing and the lead time callback.
+*/
+#include "thermo8_sim.h"
+
+static int     cbCalls;
+static uint8_t cbLimit;
+static uint16_t cbSecs;
+
+static void predCb(uint8_t limit, uint16_t secs)
+{
+    cbCalls++;
+    cbLimit = limit;
+    cbSecs  = secs;
+}
+
+int main()
+{
+    T_thermo8_pred pred;
+    int i;
+
+    /* too few samples */
+    thermo8_predInit( &pred, 1000, 800, 1600 );
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == THERMO8_PRED_NEVER );
+    thermo8_predUpdate( &pred, 400 );
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == THERMO8_PRED_NEVER );
+
+    /* +1/16 C per 1 s sample, the window ends at 407 */
+    thermo8_predInit( &pred, 1000, 457, 507 );
+    for( i = 0; i < 8; i++ )
+    {
+        thermo8_predUpdate( &pred, 400 + i );
+    }
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == 50 );
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TCRIT ) == 100 );
+
+    /* the window slides, older samples leave the fit */
+    for( i = 0; i < 8; i++ )
+    {
+        thermo8_predUpdate( &pred, 500 + 4 * i );
+    }
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TCRIT ) == 0 );
+    thermo8_predInit( &pred, 250, 800, 1600 );
+    for( i = 0; i < 20; i++ )
+    {
+        thermo8_predUpdate( &pred, (int16_t)( 400 + 4 * i ) );
+    }
+    /* newest 476, 4 codes per 250 ms */
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == 20 );
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TCRIT ) == 70 );
+
+    /* a slow ramp far from the limit, 5000 s away */
+    thermo8_predInit( &pred, 1000, 407 + 5000, 407 + 30000 );
+    for( i = 0; i < 8; i++ )
+    {
+        thermo8_predUpdate( &pred, 400 + i );
+    }
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == 5000 );
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TCRIT ) == 30000 );
+
+    /* beyond the range of the result */
+    thermo8_predInit( &pred, 60000, 407 + 5000, 800 );
+    for( i = 0; i < 8; i++ )
+    {
+        thermo8_predUpdate( &pred, 400 + i );
+    }
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == THERMO8_PRED_NEVER - 1 );
+
+    /* flat and falling trends never cross, a zero period is one ms */
+    thermo8_predInit( &pred, 0, 800, 1600 );
+    CHECK( pred.periodMs == 1 );
+    for( i = 0; i < 8; i++ )
+    {
+        thermo8_predUpdate( &pred, 400 );
+    }
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == THERMO8_PRED_NEVER );
+    for( i = 0; i < 8; i++ )
+    {
+        thermo8_predUpdate( &pred, 400 - i );
+    }
+    CHECK( thermo8_predSeconds( &pred, THERMO8_REG_TUPPER ) == THERMO8_PRED_NEVER );
+
+    /* callback, once per approach, armed again when the trend recedes */
+    thermo8_predInit( &pred, 1000, 480, 1600 );
+    thermo8_predSetCallback( &pred, 30, predCb );
+    for( i = 0; i < 80 && !cbCalls; i++ )
+    {
+        thermo8_predUpdate( &pred, 400 + i );
+    }
+    CHECK( cbCalls == 1 );
+    CHECK( cbLimit == THERMO8_REG_TUPPER );
+    CHECK( cbSecs < 30 );
+    CHECK( 400 + i - 1 + cbSecs == 480 );
+    thermo8_predUpdate( &pred, 400 + i );
+    CHECK( cbCalls == 1 );
+    for( i = 0; i < 8; i++ )
+    {
+        thermo8_predUpdate( &pred, 300 );
+    }
+    CHECK( cbCalls == 1 );
+    for( i = 0; i < 80 && ( cbCalls == 1 ); i++ )
+    {
+        thermo8_predUpdate( &pred, 440 + i );
+    }
+    CHECK( cbCalls == 2 );
+
+    return sim_done( "test_pred" );
+}
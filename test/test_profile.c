@@ -0,0 +1,92 @@
+/*
+    Configuration profiles
+
+    Applies profiles to the simulated sensors: register images, writes
+    skipped from the cache, locks set last, locked limits that do or do
+    not match the profile, and the device mask of profileApplyAll.
+*/
+#include "thermo8_sim.h"
+
+static void profileSet(T_thermo8_profile *p, int16_t tUpper, uint8_t locks)
+{
+    p->resolution = THERMO8_R025C_65MS;
+    p->tUpper     = tUpper;
+    p->tLower     = 10 * 16;
+    p->tCrit      = 80 * 16;
+    p->hysteresis = THERMO8_THYS_1C5;
+    p->alertMode  = THERMO8_ALERT_ON_ALL;
+    p->locks      = locks;
+}
+
+int main()
+{
+    T_thermo8_profile profile;
+    T_sim_dev *d;
+    long starts;
+    int i;
+
+    sim_attach( SIM_ADDR_BASE );
+    d = &sim_dev[ SIM_ADDR_BASE ];
+    CHECK( thermo8_discover() == 0xFF );
+
+    /* every register takes the image */
+    profileSet( &profile, 28 * 16, 0 );
+    CHECK( thermo8_profileApply( &profile ) == 0 );
+    CHECK( d->reg[ 2 ] == 0x01C0 );
+    CHECK( d->reg[ 3 ] == 0x00A0 );
+    CHECK( d->reg[ 4 ] == 0x0500 );
+    CHECK( d->reg[ 8 ] == THERMO8_R025C_65MS );
+    CHECK( ( d->reg[ 1 ] & 0x06C9 ) == ( 0x0200 | THERMO8_CFG_ALERT_MOD | THERMO8_CFG_ALERT_CNT ) );
+
+    /* a second apply is served from the cache */
+    starts = sim_starts;
+    CHECK( thermo8_profileApply( &profile ) == 0 );
+    CHECK( sim_starts == starts );
+
+    /* one changed limit is one write */
+    profileSet( &profile, 30 * 16, 0 );
+    CHECK( thermo8_profileApply( &profile ) == 0 );
+    CHECK( d->reg[ 2 ] == 0x01E0 );
+    CHECK( sim_starts == starts + 1 );
+
+    /* locks are set last, after the limits */
+    profileSet( &profile, 28 * 16, THERMO8_LOCK_WIN | THERMO8_LOCK_CRIT );
+    CHECK( thermo8_profileApply( &profile ) == 0 );
+    CHECK( d->reg[ 2 ] == 0x01C0 );
+    CHECK( ( d->reg[ 1 ] & 0x00C0 ) == 0x00C0 );
+
+    /* the same limits under lock still apply */
+    thermo8_cacheInvalidate();
+    CHECK( thermo8_profileApply( &profile ) == 0 );
+    CHECK( thermo8_getError() == 0 );
+
+    /* a locked limit which differs is reported, not silently skipped */
+    profileSet( &profile, 35 * 16, THERMO8_LOCK_WIN | THERMO8_LOCK_CRIT );
+    CHECK( thermo8_profileApply( &profile ) == THERMO8_ERR_LOCKED );
+    CHECK( d->reg[ 2 ] == 0x01C0 );
+    CHECK( thermo8_getError() == THERMO8_ERR_LOCKED );
+    thermo8_cacheInvalidate();
+    CHECK( thermo8_profileApply( &profile ) == THERMO8_ERR_LOCKED );
+    thermo8_getError();
+
+    /* applyAll leaves locked and failing devices out of the mask */
+    profileSet( &profile, 35 * 16, 0 );
+    sim_nackAddr  = SIM_ADDR_BASE + 5;
+    sim_nackCount = -1;
+    CHECK( thermo8_profileApplyAll( &profile ) == 0xDE );
+    CHECK( thermo8_getError() == THERMO8_ERR_LOCKED );
+    for( i = 1; i < 8; i++ )
+    {
+        if( i != 5 )
+        {
+            CHECK( sim_dev[ SIM_ADDR_BASE + i ].reg[ 2 ] == 0x0230 );
+        }
+    }
+    CHECK( sim_dev[ SIM_ADDR_BASE + 5 ].reg[ 2 ] == 0 );
+    sim_nackCount = 0;
+    CHECK( thermo8_profileApplyAll( &profile ) == 0xFE );
+    CHECK( thermo8_getError() == THERMO8_ERR_LOCKED );
+    CHECK( thermo8_getError() == 0 );
+
+    return sim_done( "test_profile" );
+}
@@ -0,0 +1,142 @@
+/*
+    Multi sensor filtering
+
+    A thousand sensors are advanced over many scans with codes that sweep
+    the whole TA range, so every sensor crosses both thresholds several
+    times. EWMA state, min / max, flags and the alert count are compared
+    after every scan against a per sensor reference written from the
+    header description.
+*/
+#include "thermo8_sim.h"
+
+#define N       1000
+#define SCANS   600
+#define LOWER   ( -160 )
+#define UPPER   800
+
+static int32_t ewma[ N ];
+static int16_t tMin[ N ];
+static int16_t tMax[ N ];
+static uint8_t flags[ N ];
+static int16_t code[ N ];
+
+static int32_t refEwma[ N ];
+static int16_t refMin[ N ];
+static int16_t refMax[ N ];
+
+static uint32_t seed = 7;
+
+static uint32_t rnd()
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return seed >> 8;
+}
+
+/* floor( d / 2^s ) without relying on the shift of negative values */
+static int32_t floorDiv(int32_t d, uint8_t s)
+{
+    int32_t q = d / ( 1L << s );
+
+    if( ( q * ( 1L << s ) != d ) && ( d < 0 ) )
+    {
+        q--;
+    }
+    return q;
+}
+
+int main()
+{
+    T_thermo8_series series;
+    uint16_t alerts;
+    uint16_t ref;
+    long bad = 0;
+    int16_t v;
+    uint8_t f;
+    int scan;
+    int i;
+
+    thermo8_seriesInit( &series, N, ewma, tMin, tMax, flags, 3, LOWER, UPPER );
+    for( i = 0; i < N; i++ )
+    {
+        CHECK( flags[ i ] == 0 );
+    }
+
+    for( scan = 0; scan < SCANS; scan++ )
+    {
+        for( i = 0; i < N; i++ )
+        {
+            /* sensor i sweeps with its own phase, plus noise, clamped to the TA range */
+            int32_t c = ( ( scan * 37 + i * 11 ) % 400 - 200 ) * 20 + (int32_t)( rnd() % 64 ) - 32;
+
+            code[ i ] = (int16_t)( c < -4096 ? -4096 : ( c > 4095 ? 4095 : c ) );
+        }
+        alerts = thermo8_seriesUpdate( &series, code );
+
+        ref = 0;
+        for( i = 0; i < N; i++ )
+        {
+            if( scan == 0 )
+            {
+                refEwma[ i ] = (int32_t)code[ i ] * 256;
+                refMin[ i ] = refMax[ i ] = code[ i ];
+            }
+            else
+            {
+                refEwma[ i ] += floorDiv( (int32_t)code[ i ] * 256 - refEwma[ i ], 3 );
+                refMin[ i ] = code[ i ] < refMin[ i ] ? code[ i ] : refMin[ i ];
+                refMax[ i ] = code[ i ] > refMax[ i ] ? code[ i ] : refMax[ i ];
+            }
+            v = (int16_t)floorDiv( refEwma[ i ], 8 );
+            f = THERMO8_SER_VALID;
+            if( v < LOWER )
+            {
+                f |= THERMO8_SER_LOWER;
+            }
+            if( v > UPPER )
+            {
+                f |= THERMO8_SER_UPPER;
+            }
+            if( f != THERMO8_SER_VALID )
+            {
+                ref++;
+            }
+            if( ( ewma[ i ] != refEwma[ i ] ) || ( tMin[ i ] != refMin[ i ] ) ||
+                ( tMax[ i ] != refMax[ i ] ) || ( flags[ i ] != f ) ||
+                ( thermo8_seriesValue( &series, i ) != v ) )
+            {
+                bad++;
+            }
+        }
+        CHECK( alerts == ref );
+    }
+    CHECK( bad == 0 );
+
+    /* the sweep reaches both ends of the range and both thresholds */
+    for( i = 0; i < N; i++ )
+    {
+        CHECK( tMin[ i ] <= -4000 + 32 );
+        CHECK( tMax[ i ] >= 3980 - 32 );
+    }
+
+    /* a constant input settles exactly, shift 0 follows the input */
+    thermo8_seriesInit( &series, N, ewma, tMin, tMax, flags, 0, LOWER, UPPER );
+    for( i = 0; i < N; i++ )
+    {
+        code[ i ] = (int16_t)( i - 500 );
+    }
+    thermo8_seriesUpdate( &series, code );
+    for( i = 0; i < N; i++ )
+    {
+        code[ i ] = -4096;
+    }
+    CHECK( thermo8_seriesUpdate( &series, code ) == N );
+    for( i = 0; i < N; i++ )
+    {
+        CHECK( thermo8_seriesValue( &series, i ) == -4096 );
+        CHECK( tMin[ i ] == -4096 );
+        CHECK( tMax[ i ] == i - 500 );
+        CHECK( flags[ i ] == ( THERMO8_SER_VALID | THERMO8_SER_LOWER ) );
+    }
+
+    return sim_done( "test_series" );
+}
@@ -0,0 +1,90 @@
+/*
+    Software I2C
+
+    Runs the bit-banged backend against the pin level MCP9808 model:
+    register reads and writes, fast mode SCL timing in simulated time,
+    clock stretching and its timeout, absent devices and the recovery of
+    a slave left driving SDA in the middle of a read.
+*/
+#define __THERMO8_BUS_SOFT__
+#include "thermo8_sim.h"
+#include "thermo8_soft.h"
+
+int main()
+{
+    uint32_t t0;
+    uint16_t v;
+    uint16_t us;
+    int16_t t;
+    int i;
+
+    pin_attach( SIM_ADDR_BASE );
+
+    /* reads, writes and the pointer / restart sequence */
+    sim_dev[ SIM_ADDR_BASE ].reg[ 5 ] = 0xC190;
+    CHECK( thermo8_readReg( THERMO8_REG_TA ) == 0xC190 );
+    CHECK( ( pin_starts == 2 ) && ( pin_stops == 1 ) );
+    CHECK( thermo8_getTemperatureRaw() == 400 );
+    sim_dev[ SIM_ADDR_BASE ].reg[ 5 ] = 0x1F90;
+    CHECK( thermo8_getTemperatureRaw() == -112 );
+    thermo8_writeReg( THERMO8_REG_TUPPER, 0x01C0 );
+    CHECK( sim_dev[ SIM_ADDR_BASE ].reg[ 2 ] == 0x01C0 );
+    thermo8_setResolution( 1 );
+    CHECK( sim_dev[ SIM_ADDR_BASE ].reg[ 8 ] == 1 );
+    CHECK( thermo8_readReg( THERMO8_REG_MANID ) == 0x0054 );
+    for( i = 1; i < 4; i++ )
+    {
+        CHECK( ( _read16n( SIM_ADDR_BASE + i, THERMO8_REG_DEVID, &v, 0 ) == 0 ) && ( v == 0x0400 ) );
+    }
+    CHECK( _read16n( 0x25, THERMO8_REG_TA, &v, 0 ) != 0 );
+    CHECK( thermo8_getError() == 0 );
+
+    /* fast mode: tLOW 1.3 us, tHIGH, tHD;STA and tSU;STO 0.6 us */
+    printf( "tLOW %lu ns, tHIGH %lu ns, tHD;STA %lu ns, tSU;STO %lu ns\n",
+            (unsigned long)pin_tLowMin, (unsigned long)pin_tHighMin,
+            (unsigned long)pin_tHdStaMin, (unsigned long)pin_tSuStoMin );
+    CHECK( pin_tLowMin >= 1300 );
+    CHECK( pin_tHighMin >= 600 );
+    CHECK( pin_tHdStaMin >= 600 );
+    CHECK( pin_tSuStoMin >= 600 );
+
+    /* a stretch below the timeout is waited out */
+    pin_stretchUs = 50;
+    t0 = sim_ns;
+    CHECK( thermo8_readReg( THERMO8_REG_DEVID ) == 0x0400 );
+    CHECK( sim_ns - t0 >= 50000UL );
+    CHECK( thermo8_getError() == 0 );
+
+    /* the timeout is measured in time, not in polls */
+    pin_stretchUs = 5000;
+    t0 = sim_ns;
+    CHECK( _read16n( SIM_ADDR_BASE, THERMO8_REG_DEVID, &v, 0 ) != 0 );
+    printf( "stretch timeout after %lu us\n", (unsigned long)( ( sim_ns - t0 ) / 1000 ) );
+    CHECK( sim_ns - t0 >= THERMO8_SOFT_STRETCH * 1000UL );
+    CHECK( sim_ns - t0 <= 3 * THERMO8_SOFT_STRETCH * 1000UL );
+
+    pin_stretchUs = 0;
+    sim_ns += 5000000UL;
+    CHECK( ( _read16n( SIM_ADDR_BASE, THERMO8_REG_DEVID, &v, 0 ) == 0 ) && ( v == 0x0400 ) );
+
+    /* abandon a read while the slave drives a 0 data bit */
+    sim_dev[ SIM_ADDR_BASE ].reg[ 5 ] = 0x0000;
+    _swStart();
+    _swByteOut( SIM_ADDR_BASE << 1 );
+    _swByteOut( THERMO8_REG_TA );
+    _swStartCond();
+    _swByteOut( ( SIM_ADDR_BASE << 1 ) | 0x01 );
+    pin_sclSet( 1 );
+    pin_sclSet( 0 );
+    CHECK( pin_sdaLine() == 0 );
+    us = thermo8_busRecover();
+    CHECK( pin_sdaLine() == 1 );
+    CHECK( pin_mode == PIN_IDLE );
+    CHECK( us <= 21 * THERMO8_SOFT_HALF_US );
+    sim_dev[ SIM_ADDR_BASE ].reg[ 5 ] = 0x0190;
+    CHECK( thermo8_readReg( THERMO8_REG_TA ) == 0x0190 );
+    t = thermo8_getTemperatureRaw();
+    CHECK( t == 400 );
+
+    return sim_done( "test_soft_i2c" );
+}
@@ -0,0 +1,118 @@
+/*
+    Staggered conversions
+
+    Eight sensors at the 250 ms resolution, and then five of them, are
+    scheduled with thermo8_stagInit and polled every millisecond. The
+    read slots must be evenly spaced over the conversion period, no poll
+    may read more than one sensor, every sensor is read once per period
+    and its sample is at most 1 ms old.
+*/
+#include "thermo8_sim.h"
+
+#define PERIODS     12
+
+static void run(uint8_t expect)
+{
+    T_thermo8_stag stag;
+    uint32_t last[ 8 ];
+    long reads[ 8 ];
+    long busy = 0;
+    uint32_t now;
+    uint16_t gap;
+    uint8_t  n = 0;
+    uint8_t  prev = 0xFF;
+    uint8_t  mask;
+    int i;
+
+    for( i = 0; i < 8; i++ )
+    {
+        n += ( expect >> i ) & 0x01;
+    }
+    CHECK( thermo8_discover() == expect );
+    CHECK( thermo8_stagInit( &stag, 1000 ) == expect );
+    CHECK( stag.convMs == 250 );
+    CHECK( stag.errors == 0 );
+    for( i = 0; i < 8; i++ )
+    {
+        reads[ i ] = 0;
+        if( !( expect & ( 1 << i ) ) )
+        {
+            continue;
+        }
+        /* every sensor waits in shutdown for its phase */
+        CHECK( sim_dev[ SIM_ADDR_BASE + i ].reg[ 1 ] & 0x0100 );
+        if( prev != 0xFF )
+        {
+            gap = stag.slotMs[ i ] - stag.slotMs[ prev ];
+            CHECK( ( gap == 250 / n ) || ( gap == 250 / n + 1 ) );
+        }
+        else
+        {
+            CHECK( stag.slotMs[ i ] == 0 );
+        }
+        prev = i;
+    }
+
+    for( now = 1000; now < 1000 + 250 * PERIODS; now++ )
+    {
+        mask = thermo8_stagPoll( &stag, now );
+        if( mask & ( mask - 1 ) )
+        {
+            busy++;
+        }
+        for( i = 0; i < 8; i++ )
+        {
+            if( mask & ( 1 << i ) )
+            {
+                /* one conversion period between the reads of a sensor */
+                if( reads[ i ] )
+                {
+                    CHECK( now - last[ i ] == 250 );
+                }
+                last[ i ] = now;
+                reads[ i ]++;
+                CHECK( stag.tRaw[ i ] == 400 );
+            }
+        }
+        CHECK( stag.fresh == mask );
+    }
+    CHECK( busy == 0 );
+    CHECK( stag.errors == 0 );
+    for( i = 0; i < 8; i++ )
+    {
+        if( expect & ( 1 << i ) )
+        {
+            CHECK( stag.awake & ( 1 << i ) );
+            CHECK( !( sim_dev[ SIM_ADDR_BASE + i ].reg[ 1 ] & 0x0100 ) );
+            CHECK( ( reads[ i ] == PERIODS - 1 ) || ( reads[ i ] == PERIODS - 2 ) );
+            CHECK( stag.ageMax[ i ] <= 1 );
+        }
+        else
+        {
+            CHECK( reads[ i ] == 0 );
+        }
+    }
+    printf( "%d sensors, slots", n );
+    for( i = 0; i < 8; i++ )
+    {
+        if( expect & ( 1 << i ) )
+        {
+            printf( " %u", stag.slotMs[ i ] );
+        }
+    }
+    printf( " ms\n" );
+}
+
+int main()
+{
+    sim_attach( SIM_ADDR_BASE );
+    run( 0xFF );
+
+    sim_attach( SIM_ADDR_BASE );
+    sim_dev[ SIM_ADDR_BASE + 1 ].present = 0;
+    sim_dev[ SIM_ADDR_BASE + 4 ].present = 0;
+    sim_dev[ SIM_ADDR_BASE + 6 ].present = 0;
+    run( 0xAD );
+
+    return sim_done( "test_stagger" );
+}
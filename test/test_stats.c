@@ -0,0 +1,139 @@
+/*
+    Streaming statistics
+
+    Compares update and merge against a double precision reference over
+    random windows, checks reset and the saturated accumulator.
+*/
+#include "thermo8_sim.h"
+#include <math.h>
+
+#define WINDOWS     200
+#define SAMPLES     1000
+
+static uint32_t seed = 7;
+
+static int16_t rndTemp(int16_t centre, int16_t spread)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return (int16_t)( centre + (int32_t)( ( seed >> 8 ) % ( 2 * spread + 1 ) ) - spread );
+}
+
+/* mean in 1/256 C rounded down, population variance in (1/256 C)^2 */
+static void reference(const int16_t *v, long n, int32_t *mean, double *var)
+{
+    double s = 0;
+    double m;
+    double q = 0;
+    long i;
+
+    for( i = 0; i < n; i++ )
+    {
+        s += v[ i ];
+    }
+    m = s / n;
+    for( i = 0; i < n; i++ )
+    {
+        q += ( v[ i ] - m ) * ( v[ i ] - m );
+    }
+    *mean = (int32_t)floor( s * 16 / n );
+    *var  = q / n * 256;
+}
+
+int main()
+{
+    static int16_t v[ 2 * SAMPLES ];
+    T_thermo8_stats a;
+    T_thermo8_stats b;
+    T_thermo8_stats all;
+    int32_t mean;
+    double var;
+    long badMean = 0;
+    long badVar = 0;
+    long w;
+    long i;
+    long na;
+    int16_t tMin;
+    int16_t tMax;
+
+    for( w = 0; w < WINDOWS; w++ )
+    {
+        na = 1 + w * 7 % ( 2 * SAMPLES - 1 );
+        thermo8_statsReset( &a );
+        thermo8_statsReset( &b );
+        thermo8_statsReset( &all );
+        tMin = 0x7FFF;
+        tMax = -0x8000;
+        for( i = 0; i < 2 * SAMPLES; i++ )
+        {
+            v[ i ] = rndTemp( (int16_t)( w * 13 % 800 - 400 ), (int16_t)( 1 + w % 64 ) );
+            thermo8_statsUpdate( i < na ? &a : &b, v[ i ] );
+            thermo8_statsUpdate( &all, v[ i ] );
+            tMin = v[ i ] < tMin ? v[ i ] : tMin;
+            tMax = v[ i ] > tMax ? v[ i ] : tMax;
+        }
+
+        /* single window */
+        reference( v, 2 * SAMPLES, &mean, &var );
+        if( ( thermo8_statsMean( &all ) != mean ) || ( all.count != 2 * SAMPLES ) ||
+            ( all.tMin != tMin ) || ( all.tMax != tMax ) )
+        {
+            badMean++;
+        }
+        if( fabs( thermo8_statsVariance( &all ) - var ) > 32 + var * 1e-3 )
+        {
+            badVar++;
+        }
+
+        /* two windows merged */
+        thermo8_statsMerge( &a, &b );
+        if( ( thermo8_statsMean( &a ) != mean ) || ( a.count != 2 * SAMPLES ) ||
+            ( a.tMin != tMin ) || ( a.tMax != tMax ) )
+        {
+            badMean++;
+        }
+        if( fabs( thermo8_statsVariance( &a ) - var ) > 32 + var * 1e-3 )
+        {
+            badVar++;
+        }
+    }
+    CHECK( badMean == 0 );
+    CHECK( badVar == 0 );
+
+    /* a constant input has no spread */
+    thermo8_statsReset( &a );
+    for( i = 0; i < 5000; i++ )
+    {
+        thermo8_statsUpdate( &a, -123 );
+    }
+    CHECK( thermo8_statsMean( &a ) == -123 * 16 );
+    CHECK( thermo8_statsVariance( &a ) == 0 );
+    CHECK( thermo8_statsStddev( &a ) == 0 );
+
+    /* merging into or from an empty window */
+    thermo8_statsReset( &b );
+    thermo8_statsMerge( &b, &a );
+    CHECK( ( b.count == 5000 ) && ( thermo8_statsMean( &b ) == -123 * 16 ) );
+    thermo8_statsReset( &b );
+    thermo8_statsMerge( &a, &b );
+    CHECK( a.count == 5000 );
+
+    /* reset */
+    thermo8_statsReset( &a );
+    CHECK( a.count == 0 );
+    CHECK( thermo8_statsMean( &a ) == 0 );
+    thermo8_statsUpdate( &a, 400 );
+    CHECK( ( a.count == 1 ) && ( a.tMin == 400 ) && ( a.tMax == 400 ) );
+    CHECK( thermo8_statsMean( &a ) == 400 * 16 );
+    CHECK( thermo8_statsVariance( &a ) == 0 );
+
+    /* a saturated window keeps tracking the extremes only */
+    a.count = THERMO8_STATS_MAX_COUNT;
+    mean = thermo8_statsMean( &a );
+    thermo8_statsUpdate( &a, -800 );
+    thermo8_statsUpdate( &a, 1600 );
+    CHECK( a.count == THERMO8_STATS_MAX_COUNT );
+    CHECK( ( a.tMin == -800 ) && ( a.tMax == 1600 ) );
+    CHECK( thermo8_statsMean( &a ) == mean );
+
+    return sim_done( "test_stats" );
+}
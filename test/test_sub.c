@@ -0,0 +1,92 @@
+/*
+    Sample stream service
+
+    Two hundred subscriptions with mixed device masks and intervals are
+    served from one acquisition cycle. Every frame is decoded and checked
+    against the layout in the header, and serving must not touch the bus.
+*/
+#include "thermo8_sim.h"
+
+#define SUBS    200
+
+static long frames[ SUBS ];
+static long bad;
+
+static void frameOut(uint8_t *frame, uint16_t len)
+{
+    uint8_t sum = 0;
+    uint8_t id;
+    uint8_t n;
+    uint8_t mask;
+    uint16_t k;
+    int16_t t;
+
+    for( k = 0; k < len - 1; k++ )
+    {
+        sum += frame[ k ];
+    }
+    id = frame[ 1 ];
+    n  = frame[ 2 ];
+    mask = ( id % 2 ) ? 0xFF : 0x0F;
+    if( ( frame[ 0 ] != 0xA5 ) || ( sum != frame[ len - 1 ] ) || ( len != 8 + 4 * n ) ||
+        ( n != ( ( mask == 0xFF ) ? 8 : 4 ) ) )
+    {
+        bad++;
+        return;
+    }
+    for( k = 0; k < n; k++ )
+    {
+        t = (int16_t)( (uint16_t)frame[ 9 + 4 * k ] << 8 | frame[ 10 + 4 * k ] );
+        if( ( frame[ 7 + 4 * k ] != k ) || ( t != 400 + k ) )
+        {
+            bad++;
+        }
+    }
+    frames[ id ]++;
+}
+
+int main()
+{
+    static T_thermo8_sub subs[ SUBS ];
+    T_thermo8_latest latest;
+    T_thermo8_acq acq;
+    uint32_t now;
+    long starts;
+    long served = 0;
+    int i;
+
+    sim_attach( SIM_ADDR_BASE );
+    for( i = 0; i < 8; i++ )
+    {
+        sim_dev[ SIM_ADDR_BASE + i ].reg[ 5 ] = 0x0190 + i;
+    }
+    CHECK( thermo8_discover() == 0xFF );
+    thermo8_acqInit( &acq, 100 );
+    thermo8_latestInit( &latest );
+    thermo8_acqSetLatest( &acq, &latest );
+    for( i = 0; i < SUBS; i++ )
+    {
+        thermo8_subInit( &subs[ i ], i, ( i % 2 ) ? 0xFF : 0x0F, 100 * ( 1 + i % 5 ), frameOut );
+    }
+    sim_starts = 0;
+
+    for( now = 0; now <= 1000; now += 10 )
+    {
+        thermo8_acqPoll( &acq, now );
+        starts = sim_starts;
+        served += thermo8_subServe( subs, SUBS, &latest, now );
+        CHECK( sim_starts == starts );
+    }
+
+    printf( "%ld frames from %lu cycles, %ld bus transactions\n",
+            served, (unsigned long)acq.cycles, sim_starts );
+    CHECK( bad == 0 );
+    CHECK( acq.cycles == 11 );
+    CHECK( sim_starts == 11 * 8 );
+    for( i = 0; i < SUBS; i++ )
+    {
+        CHECK( frames[ i ] == 1 + 1000 / ( 100 * ( 1 + i % 5 ) ) );
+    }
+
+    return sim_done( "test_sub" );
+}
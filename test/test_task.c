@@ -0,0 +1,114 @@
+/*
+    Cooperative tasks
+
+    Two hundred tasks share the eight sensors and read each one three times
+    through the asynchronous queue with the blocking backend. The executor
+    serves the queue inside every pass, so all reads complete within a
+    bounded number of passes although the queue holds only sixteen
+    transactions. A task on an absent sensor stops with its error latched.
+*/
+#include "thermo8_sim.h"
+
+#define TASKS   200
+#define READS   3
+
+static T_thermo8_task tasks[ TASKS ];
+static int reads[ TASKS ];
+static long bad;
+
+static void body(T_thermo8_task *t)
+{
+    int i = t - tasks;
+
+    if( reads[ i ] == READS )
+    {
+        return;
+    }
+    THERMO8_TASK_BEGIN( t );
+    THERMO8_TASK_AWAIT( t, thermo8_taskRead( t ) );
+    if( t->tRaw != 400 + ( t->dev.slave - SIM_ADDR_BASE ) )
+    {
+        bad++;
+    }
+    reads[ i ]++;
+    THERMO8_TASK_END( t );
+}
+
+static int pending()
+{
+    int n = 0;
+    int i;
+
+    for( i = 0; i < TASKS; i++ )
+    {
+        if( ( reads[ i ] != READS ) && ( tasks[ i ].line != THERMO8_TASK_STOPPED ) )
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+int main()
+{
+    uint32_t passes = 0;
+    int i;
+
+    sim_attach( SIM_ADDR_BASE );
+    for( i = 0; i < 8; i++ )
+    {
+        sim_dev[ SIM_ADDR_BASE + i ].reg[ 5 ] = 0x0190 + i;
+    }
+    CHECK( thermo8_discover() == 0xFF );
+    thermo8_asyncInit( 0 );
+    for( i = 0; i < TASKS; i++ )
+    {
+        thermo8_taskInit( &tasks[ i ], SIM_ADDR_BASE + i % 8 );
+    }
+    sim_starts = 0;
+
+    while( pending() && ( passes < 1000 ) )
+    {
+        thermo8_taskRun( tasks, TASKS, body, passes );
+        passes++;
+    }
+    printf( "%d tasks, %d reads in %lu passes, %ld bus transactions\n",
+            TASKS, TASKS * READS, (unsigned long)passes, sim_starts );
+    CHECK( bad == 0 );
+    for( i = 0; i < TASKS; i++ )
+    {
+        CHECK( reads[ i ] == READS );
+    }
+    CHECK( sim_starts == TASKS * READS );
+    CHECK( passes <= 2 * TASKS * READS / THERMO8_TASK_POLLS + 2 );
+
+    /* a task on an absent sensor stops, the others keep running */
+    memset( reads, 0, sizeof( reads ) );
+    sim_dev[ SIM_ADDR_BASE + 3 ].present = 0;
+    for( i = 0; i < TASKS; i++ )
+    {
+        thermo8_taskInit( &tasks[ i ], SIM_ADDR_BASE + i % 8 );
+    }
+    passes = 0;
+    while( pending() && ( passes < 1000 ) )
+    {
+        thermo8_taskRun( tasks, TASKS, body, passes );
+        passes++;
+    }
+    for( i = 0; i < TASKS; i++ )
+    {
+        if( i % 8 == 3 )
+        {
+            CHECK( tasks[ i ].line == THERMO8_TASK_STOPPED );
+            CHECK( thermo8_devGetError( &tasks[ i ].dev ) != 0 );
+            CHECK( reads[ i ] == 0 );
+        }
+        else
+        {
+            CHECK( reads[ i ] == READS );
+        }
+    }
+    CHECK( passes <= 2 * TASKS * READS / THERMO8_TASK_POLLS + 2 );
+
+    return sim_done( "test_task" );
+}
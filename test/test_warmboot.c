@@ -0,0 +1,69 @@
+/*
+    Warm boot check
+
+    A sensor keeps its registers over an MCU reset. The check has to
+    accept a sensor configured with the profile, reject any register that
+    differs, read only and never report a warm boot on a bus error.
+*/
+#include "thermo8_sim.h"
+
+int main()
+{
+    T_thermo8_profile profile;
+    T_sim_dev *d;
+    T_sim_dev saved;
+    long starts;
+    int r;
+
+    sim_attach( SIM_ADDR_BASE );
+    d = &sim_dev[ SIM_ADDR_BASE ];
+    profile.resolution = THERMO8_R0125C_130MS;
+    profile.tUpper     = 30 * 16;
+    profile.tLower     = -5 * 16;
+    profile.tCrit      = 70 * 16;
+    profile.hysteresis = THERMO8_THYS_3C;
+    profile.alertMode  = THERMO8_TCRIT_ONLY_ALERT;
+    profile.locks      = 0;
+
+    /* power on defaults */
+    CHECK( thermo8_warmBootCheck( &profile ) == 0 );
+    CHECK( thermo8_profileApply( &profile ) == 0 );
+
+    /* MCU reset, the sensor keeps its state */
+    saved = *d;
+    thermo8_cacheInvalidate();
+    starts = sim_starts;
+    CHECK( thermo8_warmBootCheck( &profile ) == 1 );
+    CHECK( sim_starts - starts == 5 );
+    CHECK( memcmp( d->reg, saved.reg, sizeof( d->reg ) ) == 0 );
+
+    /* a pending alert status is not a configuration change */
+    d->reg[ 1 ] |= THERMO8_CFG_ALERT_STAT;
+    CHECK( thermo8_warmBootCheck( &profile ) == 1 );
+
+    /* every register is compared */
+    for( r = 1; r <= 4; r++ )
+    {
+        *d = saved;
+        d->reg[ r ] ^= ( r == 1 ) ? THERMO8_CFG_ALERT_SEL : 0x0010;
+        CHECK( thermo8_warmBootCheck( &profile ) == 0 );
+    }
+    *d = saved;
+    d->reg[ 8 ] = THERMO8_R00625C_250MS;
+    CHECK( thermo8_warmBootCheck( &profile ) == 0 );
+
+    /* a bus error is never a warm boot */
+    *d = saved;
+    sim_nackAddr  = SIM_ADDR_BASE;
+    sim_nackCount = -1;
+    CHECK( thermo8_warmBootCheck( &profile ) == 0 );
+    sim_nackCount = 0;
+    thermo8_getError();
+    CHECK( thermo8_warmBootCheck( &profile ) == 1 );
+
+    /* no device selected */
+    thermo8_i2cDriverInit( (T_THERMO8_P)&sim_gpio, (T_THERMO8_P)0, 0x40 );
+    CHECK( thermo8_warmBootCheck( &profile ) == 0 );
+
+    return sim_done( "test_warmboot" );
+}
@@ -0,0 +1,310 @@
+/*
+    thermo8_sim.h
+
+    Host test harness, simulated MCP9808 bus behind the HAL entry points.
+
+    The driver source is included directly so the tests can reach the
+    private helpers. Define __THERMO8_BUS_STATIC__ ( and the bus macros on
+    top of sim_start() / sim_write() / sim_read() ) or __THERMO8_BUS_SOFT__
+    before including this file to test the other bus bindings.
+*/
+#ifndef _THERMO8_SIM_H_
+#define _THERMO8_SIM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define END_MODE_RESTART    0
+#define END_MODE_STOP       1
+
+/* simulated time, advanced by the delay functions only */
+static volatile uint32_t sim_ns;
+
+void Delay_100ms() { sim_ns += 100000000UL; }
+void Delay_1ms()   { sim_ns += 1000000UL; }
+void Delay_us(unsigned us) { sim_ns += us * 1000UL; }
+
+/*
+  Bus model. Devices sit directly on the bus ( sim_dev[] ) or on a
+  TCA9548A channel ( sim_chan[][] ). A pointer write sets the register
+  pointer, a read returns the register it points to.
+*/
+typedef struct
+{
+    uint8_t     present;
+    uint16_t    reg[ 9 ];
+    uint8_t     ptr;
+
+}T_sim_dev;
+
+static T_sim_dev sim_dev[ 128 ];
+static T_sim_dev sim_chan[ 8 ][ 8 ][ 128 ];
+static uint8_t   sim_muxPresent;
+static uint8_t   sim_muxCtl[ 8 ];
+
+/* fault injection */
+static int sim_nackAddr = -1;
+static int sim_nackCount;               /* NACKs left, -1 - forever */
+static int sim_startFail;               /* failed starts left */
+
+/* statistics */
+static volatile long sim_starts;
+static volatile long sim_muxWrites;
+static volatile long sim_collisions;
+static volatile long sim_overlaps;
+static volatile int  sim_active;
+static uint8_t       sim_int = 1;
+
+#define SIM_ADDR_BASE   0x18
+#define SIM_MUX_BASE    0x70
+
+static void sim_devInit(T_sim_dev *d)
+{
+    memset( d, 0, sizeof( *d ) );
+    d->present = 1;
+    d->reg[ 5 ] = 0x0190;               /* 25 C */
+    d->reg[ 6 ] = 0x0054;
+    d->reg[ 7 ] = 0x0400;
+    d->reg[ 8 ] = 0x03;
+}
+
+static void sim_reset()
+{
+    int i;
+
+    memset( sim_dev, 0, sizeof( sim_dev ) );
+    memset( sim_chan, 0, sizeof( sim_chan ) );
+    memset( sim_muxCtl, 0, sizeof( sim_muxCtl ) );
+    sim_muxPresent = 0;
+    for( i = SIM_ADDR_BASE; i < SIM_ADDR_BASE + 8; i++ )
+    {
+        sim_devInit( &sim_dev[ i ] );
+    }
+    sim_nackAddr  = -1;
+    sim_nackCount = 0;
+    sim_startFail = 0;
+    sim_starts = sim_muxWrites = sim_collisions = sim_overlaps = 0;
+    sim_active = 0;
+    sim_int = 1;
+}
+
+/* device answering at addr, equal addresses on open channels collide */
+static T_sim_dev *sim_find(uint8_t addr)
+{
+    T_sim_dev *d = 0;
+    int hits = 0;
+    int m;
+    int c;
+
+    if( sim_dev[ addr ].present )
+    {
+        d = &sim_dev[ addr ];
+        hits++;
+    }
+    for( m = 0; m < 8; m++ )
+    {
+        if( !( sim_muxPresent & ( 1 << m ) ) )
+        {
+            continue;
+        }
+        for( c = 0; c < 8; c++ )
+        {
+            if( ( sim_muxCtl[ m ] & ( 1 << c ) ) && sim_chan[ m ][ c ][ addr ].present )
+            {
+                d = &sim_chan[ m ][ c ][ addr ];
+                hits++;
+            }
+        }
+    }
+    if( hits > 1 )
+    {
+        sim_collisions++;
+    }
+    return d;
+}
+
+/* locked limits ACK and keep their value, lock bits clear on reset only */
+static void sim_regWrite(T_sim_dev *d, uint16_t v)
+{
+    uint16_t cfg = d->reg[ 1 ];
+
+    if( ( ( d->ptr == 2 ) || ( d->ptr == 3 ) ) && ( cfg & 0x0040 ) )
+    {
+        return;
+    }
+    if( ( d->ptr == 4 ) && ( cfg & 0x0080 ) )
+    {
+        return;
+    }
+    if( d->ptr == 1 )
+    {
+        /* alert status is read only, interrupt clear releases it */
+        v = ( v & ~0x0030 ) | ( ( v & 0x0020 ) ? 0 : ( cfg & 0x0010 ) );
+        v |= cfg & 0x00C0;
+    }
+    d->reg[ d->ptr ] = v;
+}
+
+static int sim_nack(uint8_t addr)
+{
+    if( ( sim_nackAddr != (int)addr ) || ( sim_nackCount == 0 ) )
+    {
+        return 0;
+    }
+    if( sim_nackCount > 0 )
+    {
+        sim_nackCount--;
+    }
+    return 1;
+}
+
+static void sim_end()
+{
+    __sync_fetch_and_sub( &sim_active, 1 );
+}
+
+static int sim_start()
+{
+    if( sim_startFail > 0 )
+    {
+        sim_startFail--;
+        return 1;
+    }
+    if( __sync_fetch_and_add( &sim_active, 1 ) != 0 )
+    {
+        __sync_fetch_and_add( &sim_overlaps, 1 );
+    }
+    __sync_fetch_and_add( &sim_starts, 1 );
+    return 0;
+}
+
+static int sim_write(uint8_t addr, uint8_t *buf, uint16_t n, uint8_t mode)
+{
+    T_sim_dev *d;
+    int m;
+
+    if( ( addr & 0x78 ) == SIM_MUX_BASE )
+    {
+        m = addr & 0x07;
+        if( !( sim_muxPresent & ( 1 << m ) ) || sim_nack( addr ) )
+        {
+            sim_end();
+            return 1;
+        }
+        sim_muxCtl[ m ] = buf[ 0 ];
+        sim_muxWrites++;
+        if( mode == END_MODE_STOP )
+        {
+            sim_end();
+        }
+        return 0;
+    }
+    d = sim_find( addr );
+    if( !d || sim_nack( addr ) )
+    {
+        sim_end();
+        return 1;
+    }
+    d->ptr = buf[ 0 ] & 0x0F;
+    if( n == 2 )
+    {
+        d->reg[ d->ptr ] = buf[ 1 ];
+    }
+    if( n == 3 )
+    {
+        sim_regWrite( d, (uint16_t)buf[ 1 ] << 8 | buf[ 2 ] );
+    }
+    if( mode == END_MODE_STOP )
+    {
+        sim_end();
+    }
+    return 0;
+}
+
+static int sim_read(uint8_t addr, uint8_t *buf, uint16_t n, uint8_t mode)
+{
+    T_sim_dev *d;
+    uint16_t v;
+
+    ( void )mode;
+    d = sim_find( addr );
+    if( !d || sim_nack( addr ) )
+    {
+        sim_end();
+        return 1;
+    }
+    v = d->reg[ d->ptr ];
+    if( n == 2 )
+    {
+        buf[ 0 ] = (uint8_t)( v >> 8 );
+        buf[ 1 ] = (uint8_t)v;
+    }
+    else
+    {
+        buf[ 0 ] = (uint8_t)v;
+    }
+    sim_end();
+    return 0;
+}
+
+static uint8_t sim_intGet()
+{
+    return sim_int;
+}
+
+#include "__thermo8_driver.c"
+
+/* HAL entry points dispatch through pointers like the mikroSDK HAL */
+static long sim_halCalls;
+static int (*sim_startFp)() = sim_start;
+static int (*sim_writeFp)(uint8_t, uint8_t*, uint16_t, uint8_t) = sim_write;
+static int (*sim_readFp)(uint8_t, uint8_t*, uint16_t, uint8_t) = sim_read;
+
+static void hal_i2cMap(T_HAL_P i2cObj)
+{
+    ( void )i2cObj;
+}
+
+static int hal_i2cStart()
+{
+    sim_halCalls++;
+    return sim_startFp();
+}
+
+static int hal_i2cWrite(uint8_t slaveAddress, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
+{
+    sim_halCalls++;
+    return sim_writeFp( slaveAddress, pBuf, nBytes, endMode );
+}
+
+static int hal_i2cRead(uint8_t slaveAddress, uint8_t *pBuf, uint16_t nBytes, uint8_t endMode)
+{
+    sim_halCalls++;
+    return sim_readFp( slaveAddress, pBuf, nBytes, endMode );
+}
+
+static T_hal_gpioObj sim_gpio;
+
+/* resets the bus and binds the driver to the device at slave */
+static void sim_attach(uint8_t slave)
+{
+    sim_reset();
+    sim_gpio.gpioGet[ 7 ] = sim_intGet;
+    thermo8_i2cDriverInit( (T_THERMO8_P)&sim_gpio, (T_THERMO8_P)0, slave );
+    thermo8_cacheInvalidate();
+}
+
+/* checks */
+static int sim_failures;
+
+#define CHECK(c)    do { if( !(c) ) { sim_failures++; \
+                         printf( "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #c ); } } while( 0 )
+
+static int sim_done(const char *name)
+{
+    printf( "%s: %s\n", name, sim_failures ? "FAILED" : "ok" );
+    return sim_failures ? 1 : 0;
+}
+
+#endif
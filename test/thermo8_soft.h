@@ -0,0 +1,302 @@
+/*
+    thermo8_soft.h
+
+    Pin level MCP9808 model for the software I2C backend. The tests define
+    __THERMO8_BUS_SOFT__ and include thermo8_sim.h first, the model then
+    answers on the mikroBUS SCL / SDA GPIO slots for the devices of
+    sim_dev[] and records the bus timing in simulated time ( sim_ns ).
+*/
+#ifndef _THERMO8_SOFT_H_
+#define _THERMO8_SOFT_H_
+
+#define PIN_SCL     10
+#define PIN_SDA     11
+
+/* slave state */
+enum { PIN_IDLE, PIN_ADDR, PIN_WRITE, PIN_READ };
+
+static uint8_t  pin_scl = 1;            /* master SCL */
+static uint8_t  pin_sda = 1;            /* master SDA */
+static uint8_t  pin_slaveSda = 1;       /* slave SDA */
+static uint8_t  pin_mode;
+static uint8_t  pin_cnt;
+static uint8_t  pin_byte;
+static uint8_t  pin_addr;
+static uint8_t  pin_rw;
+static uint8_t  pin_wCount;
+static uint8_t  pin_nack;
+static uint8_t  pin_tx[ 2 ];
+static uint8_t  pin_txIdx;
+static uint8_t  pin_txLen;
+
+/* clock stretching after the address byte, in us */
+static uint32_t pin_stretchUs;
+static uint32_t pin_stretchEnd;
+
+/* statistics, times in ns */
+static long     pin_ops;
+static long     pin_starts;
+static long     pin_stops;
+static uint32_t pin_riseNs;
+static uint32_t pin_fallNs;
+static uint32_t pin_startNs;
+static uint32_t pin_tLowMin;
+static uint32_t pin_tHighMin;
+static uint32_t pin_tHdStaMin;
+static uint32_t pin_tSuStoMin;
+static uint8_t  pin_afterStart;
+
+static uint8_t pin_sdaLine()
+{
+    return pin_sda && pin_slaveSda;
+}
+
+static uint8_t pin_sclLine()
+{
+    return pin_scl && ( (int32_t)( sim_ns - pin_stretchEnd ) >= 0 );
+}
+
+static void pin_load()
+{
+    T_sim_dev *d = &sim_dev[ pin_addr ];
+    uint16_t v = d->reg[ d->ptr ];
+
+    if( d->ptr == 8 )
+    {
+        pin_tx[ 0 ] = (uint8_t)v;
+        pin_txLen = 1;
+    }
+    else
+    {
+        pin_tx[ 0 ] = (uint8_t)( v >> 8 );
+        pin_tx[ 1 ] = (uint8_t)v;
+        pin_txLen = 2;
+    }
+    pin_txIdx = 0;
+}
+
+/* slave samples on the rising edge */
+static void pin_rise()
+{
+    if( ( pin_mode == PIN_ADDR ) || ( pin_mode == PIN_WRITE ) )
+    {
+        if( pin_cnt < 8 )
+        {
+            pin_byte = ( pin_byte << 1 ) | pin_sdaLine();
+        }
+        pin_cnt++;
+    }
+    else if( pin_mode == PIN_READ )
+    {
+        pin_cnt++;
+        if( pin_cnt == 9 )
+        {
+            pin_nack = pin_sdaLine();
+        }
+    }
+}
+
+static void pin_storeByte()
+{
+    T_sim_dev *d = &sim_dev[ pin_addr ];
+
+    if( pin_wCount == 0 )
+    {
+        d->ptr = pin_byte & 0x0F;
+    }
+    else if( d->ptr == 8 )
+    {
+        d->reg[ 8 ] = pin_byte;
+    }
+    else if( pin_wCount == 1 )
+    {
+        d->reg[ d->ptr ] = (uint16_t)pin_byte << 8;
+    }
+    else
+    {
+        d->reg[ d->ptr ] |= pin_byte;
+    }
+    pin_wCount++;
+}
+
+/* slave drives SDA after the falling edge */
+static void pin_fall()
+{
+    if( ( pin_mode == PIN_ADDR ) || ( pin_mode == PIN_WRITE ) )
+    {
+        if( pin_cnt == 8 )
+        {
+            if( pin_mode == PIN_WRITE )
+            {
+                pin_storeByte();
+            }
+            else
+            {
+                pin_addr = pin_byte >> 1;
+                pin_rw   = pin_byte & 0x01;
+                if( !sim_dev[ pin_addr ].present )
+                {
+                    pin_mode = PIN_IDLE;
+                    return;
+                }
+                pin_stretchEnd = sim_ns + pin_stretchUs * 1000UL;
+            }
+            pin_slaveSda = 0;
+        }
+        else if( pin_cnt == 9 )
+        {
+            pin_slaveSda = 1;
+            pin_cnt = 0;
+            pin_byte = 0;
+            if( pin_mode == PIN_ADDR )
+            {
+                if( pin_rw )
+                {
+                    pin_mode = PIN_READ;
+                    pin_load();
+                    pin_slaveSda = pin_tx[ 0 ] >> 7;
+                }
+                else
+                {
+                    pin_mode = PIN_WRITE;
+                    pin_wCount = 0;
+                }
+            }
+        }
+    }
+    else if( pin_mode == PIN_READ )
+    {
+        if( pin_cnt < 8 )
+        {
+            pin_slaveSda = ( pin_tx[ pin_txIdx ] >> ( 7 - pin_cnt ) ) & 0x01;
+        }
+        else if( pin_cnt == 8 )
+        {
+            pin_slaveSda = 1;
+        }
+        else if( pin_nack )
+        {
+            pin_mode = PIN_IDLE;
+        }
+        else
+        {
+            pin_txIdx = ( pin_txIdx + 1 ) % pin_txLen;
+            pin_cnt = 0;
+            pin_slaveSda = pin_tx[ pin_txIdx ] >> 7;
+        }
+    }
+}
+
+static uint8_t pin_sclGet()
+{
+    pin_ops++;
+    return pin_sclLine();
+}
+
+static uint8_t pin_sdaGet()
+{
+    pin_ops++;
+    return pin_sdaLine();
+}
+
+static void pin_sclSet(uint8_t v)
+{
+    uint32_t t;
+
+    pin_ops++;
+    v = v ? 1 : 0;
+    if( v == pin_scl )
+    {
+        return;
+    }
+    pin_scl = v;
+    if( v )
+    {
+        t = sim_ns - pin_fallNs;
+        if( t < pin_tLowMin )
+        {
+            pin_tLowMin = t;
+        }
+        pin_riseNs = ( (int32_t)( sim_ns - pin_stretchEnd ) >= 0 ) ? sim_ns : pin_stretchEnd;
+        pin_rise();
+    }
+    else
+    {
+        t = sim_ns - pin_riseNs;
+        if( t < pin_tHighMin )
+        {
+            pin_tHighMin = t;
+        }
+        if( pin_afterStart )
+        {
+            t = sim_ns - pin_startNs;
+            if( t < pin_tHdStaMin )
+            {
+                pin_tHdStaMin = t;
+            }
+            pin_afterStart = 0;
+        }
+        pin_fallNs = sim_ns;
+        pin_fall();
+    }
+}
+
+/* SDA edges while SCL is high are START and STOP conditions */
+static void pin_sdaSet(uint8_t v)
+{
+    uint8_t old = pin_sdaLine();
+    uint32_t t;
+
+    pin_ops++;
+    pin_sda = v ? 1 : 0;
+    if( !pin_sclLine() || ( old == pin_sdaLine() ) )
+    {
+        return;
+    }
+    if( !pin_sdaLine() )
+    {
+        pin_starts++;
+        pin_startNs = sim_ns;
+        pin_afterStart = 1;
+        pin_mode = PIN_ADDR;
+        pin_cnt = 0;
+        pin_byte = 0;
+    }
+    else
+    {
+        pin_stops++;
+        t = sim_ns - pin_riseNs;
+        if( t < pin_tSuStoMin )
+        {
+            pin_tSuStoMin = t;
+        }
+        pin_mode = PIN_IDLE;
+    }
+    pin_slaveSda = 1;
+}
+
+static void pin_timingReset()
+{
+    pin_tLowMin = pin_tHighMin = pin_tHdStaMin = pin_tSuStoMin = 0xFFFFFFFFUL;
+}
+
+/* resets the bus and binds the driver to the device at slave */
+static void pin_attach(uint8_t slave)
+{
+    sim_reset();
+    pin_scl = pin_sda = pin_slaveSda = 1;
+    pin_mode = PIN_IDLE;
+    pin_stretchUs = 0;
+    pin_stretchEnd = sim_ns;
+    pin_ops = pin_starts = pin_stops = 0;
+    pin_timingReset();
+    sim_gpio.gpioGet[ 7 ] = sim_intGet;
+    sim_gpio.gpioGet[ PIN_SCL ] = pin_sclGet;
+    sim_gpio.gpioGet[ PIN_SDA ] = pin_sdaGet;
+    sim_gpio.gpioSet[ PIN_SCL ] = pin_sclSet;
+    sim_gpio.gpioSet[ PIN_SDA ] = pin_sdaSet;
+    thermo8_i2cDriverInit( (T_THERMO8_P)&sim_gpio, (T_THERMO8_P)0, slave );
+    thermo8_cacheInvalidate();
+}
+
+#endif